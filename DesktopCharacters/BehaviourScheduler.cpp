@@ -0,0 +1,226 @@
+#include "BehaviourScheduler.h"
+
+#include <cmath>
+#include <exception>
+#include <utility>
+
+void Behaviour::promise_type::unhandled_exception() const
+{
+    std::terminate();
+}
+
+Behaviour::Behaviour(Behaviour&& other) noexcept : handle(other.handle)
+{
+    other.handle = nullptr;
+}
+
+Behaviour& Behaviour::operator=(Behaviour&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+// Destroying a suspended behaviour also destroys children it awaits
+Behaviour::~Behaviour()
+{
+    if (handle)
+    {
+        handle.destroy();
+    }
+}
+
+bool Behaviour::isDone() const
+{
+    return !handle || handle.done();
+}
+
+
+BehaviourScheduler::BehaviourScheduler()
+{
+    for (uint32_t& first : wheel)
+    {
+        first = NONE;
+    }
+}
+
+void BehaviourScheduler::start(uint32_t index, Behaviour behaviour)
+{
+    if (index >= behaviours.size())
+    {
+        behaviours.resize(index + 1);
+        waiters.resize(index + 1);
+    }
+
+    if (waiters[index].timed)
+    {
+        unlink(index);
+    }
+    waiters[index] = Waiter();
+
+    behaviours[index] = std::move(behaviour);
+    if (!behaviours[index].isDone())
+    {
+        behaviours[index].handle.resume();
+    }
+}
+
+void BehaviourScheduler::clear()
+{
+    behaviours.clear();
+    waiters.clear();
+    for (uint32_t& first : wheel)
+    {
+        first = NONE;
+    }
+}
+
+BehaviourScheduler::Wait BehaviourScheduler::waitSeconds(uint32_t index, float seconds)
+{
+    Wait wait;
+    wait.scheduler = this;
+    wait.index = index;
+    wait.event = Event::None;
+    wait.steps = seconds > 0.0f ? (uint32_t)ceilf(seconds / STEP_TIME) : 0;
+    wait.ready = wait.steps == 0;
+    return wait;
+}
+
+BehaviourScheduler::Wait BehaviourScheduler::waitEvent(uint32_t index, Event event, bool alreadyHappened, float timeout)
+{
+    Wait wait;
+    wait.scheduler = this;
+    wait.index = index;
+    wait.event = event;
+    wait.steps = timeout > 0.0f ? (uint32_t)ceilf(timeout / STEP_TIME) : 0;
+    wait.ready = alreadyHappened;
+    return wait;
+}
+
+void BehaviourScheduler::tick()
+{
+    ticks++;
+    wheelPosition = (wheelPosition + 1) % WHEEL_SIZE;
+
+    // Collected first, resumed behaviours may link new waits into this slot
+    expired.clear();
+    uint32_t index = wheel[wheelPosition];
+    while (index != NONE)
+    {
+        Waiter& waiter = waiters[index];
+        const uint32_t next = waiter.next;
+        if (waiter.rounds > 0)
+        {
+            waiter.rounds--;
+        }
+        else
+        {
+            unlink(index);
+            expired.push_back(index);
+        }
+        index = next;
+    }
+
+    for (uint32_t expiredIndex : expired)
+    {
+        resume(expiredIndex, false);
+    }
+}
+
+void BehaviourScheduler::fire(uint32_t index, Event event)
+{
+    if (index < waiters.size() && waiters[index].handle && waiters[index].event == event)
+    {
+        resume(index, true);
+    }
+}
+
+BehaviourScheduler::Event BehaviourScheduler::getWaitingEvent(uint32_t index) const
+{
+    return index < waiters.size() ? waiters[index].event : Event::None;
+}
+
+float BehaviourScheduler::getTime() const
+{
+    return (float)ticks * STEP_TIME;
+}
+
+uint64_t BehaviourScheduler::getResumedCount() const
+{
+    return resumedCount;
+}
+
+void BehaviourScheduler::suspend(uint32_t index, Event event, uint32_t steps, std::coroutine_handle<> handle)
+{
+    Waiter& waiter = waiters[index];
+    waiter.handle = handle;
+    waiter.event = event;
+    waiter.fired = false;
+
+    if (steps > 0)
+    {
+        link(index, steps);
+    }
+}
+
+void BehaviourScheduler::resume(uint32_t index, bool fired)
+{
+    Waiter& waiter = waiters[index];
+    if (waiter.timed)
+    {
+        unlink(index);
+    }
+
+    std::coroutine_handle<> handle = waiter.handle;
+    waiter.handle = nullptr;
+    waiter.event = Event::None;
+    waiter.fired = fired;
+
+    resumedCount++;
+    handle.resume();
+}
+
+void BehaviourScheduler::link(uint32_t index, uint32_t steps)
+{
+    Waiter& waiter = waiters[index];
+    waiter.timed = true;
+    waiter.slot = (wheelPosition + steps) % WHEEL_SIZE;
+    waiter.rounds = (steps - 1) / WHEEL_SIZE;
+    waiter.previous = NONE;
+    waiter.next = wheel[waiter.slot];
+
+    if (waiter.next != NONE)
+    {
+        waiters[waiter.next].previous = index;
+    }
+    wheel[waiter.slot] = index;
+}
+
+void BehaviourScheduler::unlink(uint32_t index)
+{
+    Waiter& waiter = waiters[index];
+    if (waiter.previous != NONE)
+    {
+        waiters[waiter.previous].next = waiter.next;
+    }
+    else
+    {
+        wheel[waiter.slot] = waiter.next;
+    }
+
+    if (waiter.next != NONE)
+    {
+        waiters[waiter.next].previous = waiter.previous;
+    }
+
+    waiter.timed = false;
+    waiter.previous = NONE;
+    waiter.next = NONE;
+}
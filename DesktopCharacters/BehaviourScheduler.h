@@ -0,0 +1,144 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <vector>
+
+// Coroutine driving one character, started and resumed by BehaviourScheduler
+// Awaiting another Behaviour runs it in place, the awaiting one goes on once it returns.
+class Behaviour
+{
+private:
+    // Hands control back to the awaiting behaviour, roots just stop
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+public:
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation;
+
+        Behaviour get_return_object() { return Behaviour(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const {}
+        void unhandled_exception() const;
+    };
+
+    Behaviour() = default;
+    Behaviour(Behaviour&& other) noexcept;
+    Behaviour& operator=(Behaviour&& other) noexcept;
+    Behaviour(const Behaviour&) = delete;
+    Behaviour& operator=(const Behaviour&) = delete;
+    ~Behaviour();
+
+    bool isDone() const;
+
+    // co_await of a child behaviour
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept
+    {
+        handle.promise().continuation = parent;
+        return handle;
+    }
+    void await_resume() const noexcept {}
+private:
+    friend class BehaviourScheduler;
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Behaviour(std::coroutine_handle<promise_type> newHandle) : handle(newHandle) {}
+};
+
+// Resumes behaviours only when what they wait for has happened
+// Time waits sit in a wheel of simulation steps, event waits are resumed through fire(),
+// so behaviours that are waiting cost nothing per step.
+class BehaviourScheduler
+{
+public:
+    static constexpr float STEP_TIME = 1.0f / 60.0f; // One tick per simulation step
+
+    enum class Event : uint8_t
+    {
+        None, // Waits for time only
+        Grounded,
+        Airborne,
+        TargetReached
+    };
+
+    // Awaitable, co_await gives true if the event happened and false on timeout
+    class Wait
+    {
+    public:
+        bool await_ready() const noexcept { return ready; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler->suspend(index, event, steps, handle); }
+        bool await_resume() const noexcept { return ready || scheduler->waiters[index].fired; }
+    private:
+        friend class BehaviourScheduler;
+
+        BehaviourScheduler* scheduler;
+        uint32_t index;
+        Event event;
+        uint32_t steps; // Timeout, zero for none
+        bool ready;
+    };
+
+    BehaviourScheduler();
+
+    // Takes over the behaviour of character index and runs it up to its first wait
+    void start(uint32_t index, Behaviour behaviour);
+    void clear();
+
+    // Waits are only meant to be awaited by the behaviour of the same index
+    Wait waitSeconds(uint32_t index, float seconds);
+    Wait waitEvent(uint32_t index, Event event, bool alreadyHappened, float timeout = 0.0f);
+
+    // Moves timers one step on and resumes waits that timed out
+    void tick();
+
+    // Resumes behaviour of index if it waits for this event
+    void fire(uint32_t index, Event event);
+
+    Event getWaitingEvent(uint32_t index) const;
+    float getTime() const;
+    uint64_t getResumedCount() const;
+private:
+    static const uint32_t NONE = UINT32_MAX;
+    static const uint32_t WHEEL_SIZE = 256;
+
+    struct Waiter
+    {
+        std::coroutine_handle<> handle; // Innermost suspended behaviour, none while running
+        Event event = Event::None;
+        bool fired = false; // Result of last wait
+
+        // Timer wheel list, only while timed
+        bool timed = false;
+        uint32_t slot = 0;
+        uint32_t rounds = 0; // Full turns of the wheel left
+        uint32_t previous = NONE;
+        uint32_t next = NONE;
+    };
+
+    std::vector<Behaviour> behaviours; // Roots, by character
+    std::vector<Waiter> waiters; // By character
+
+    uint32_t wheel[WHEEL_SIZE]; // First waiter of each slot
+    uint32_t wheelPosition = 0;
+    uint64_t ticks = 0;
+    uint64_t resumedCount = 0;
+    std::vector<uint32_t> expired; // Scratch
+
+    void suspend(uint32_t index, Event event, uint32_t steps, std::coroutine_handle<> handle);
+    void resume(uint32_t index, bool fired);
+
+    void link(uint32_t index, uint32_t steps);
+    void unlink(uint32_t index);
+};
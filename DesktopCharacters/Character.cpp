@@ -2,35 +2,39 @@
 
 #include <iostream>
 
-Vec2 Character::worldSize;   // The logical world size for physics
-std::vector<Obstacle> Character::obstacles;
+Vec2 Character::gravity(0.0f, -20.0f);
+
+// Contacts closer in time than this are resolved in the same pass
+static const float SIMULTANEOUS_CONTACT_TIME = 1e-4f;
+
+// Upper bound of collisions() passes per update
+static const int MAX_COLLISION_ITERATIONS = 4;
+
+// Slower characters are shown standing still
+static const float WALK_ANIMATION_MIN_SPEED = 0.05f;
+
+// Follow target closer than this counts as reached for jumping
+static const float JUMP_TAKEOFF_DISTANCE = 0.01f;
 
 // Checks overlap between a character's axis range and obstacle segments
 bool Character::collisionAxisCheck(float axisMin, float axisMax, const Obstacle& obstacle, size_t& returnSegmentIndex) const
 {
-    returnSegmentIndex = 0;
-    for (const auto& segment : obstacle.segments)
-    {
-        float obstX1 = segment.min;
-        float obstX2 = segment.max;
-
-        if (obstX1 < axisMax && axisMin < obstX2)
-        {
-            return true;
-        }
-
-        returnSegmentIndex++;
-    }
-    return false;
+    return obstacle.segments.findOverlap(axisMin, axisMax, returnSegmentIndex);
 }
 
 // Handles collisions and movement during deltaTime
+// Contacts on both axes reached at (almost) the same moment are resolved together
 // Returns leftover time if a collision occurs
-float Character::collisions(float deltaTime)
+float Character::collisions(float deltaTime, const WorldSnapshot& world)
 {
-    float minimalTimeUntilCollision = FLT_MAX;
-    const Obstacle* closestObstacle = nullptr;
-    size_t closestSegmentIndex = 0;
+    struct Hit
+    {
+        float time = FLT_MAX;
+        const Obstacle* obstacle = nullptr;
+        size_t segmentIndex = 0;
+    };
+
+    Hit hitX, hitY;
 
     const Vec2 halfSize = size * 0.5f;
 
@@ -48,83 +52,83 @@ float Character::collisions(float deltaTime)
     const float charBorderX = position.x + halfSize.x * signVelX;
     const float charBorderY = position.y + halfSize.y * signVelY;
     
-    for (const auto& obstacle : obstacles)
-    {
-        size_t segmentIndex = 0;
+    // Only obstacle lines crossed by the character border during deltaTime can be hit
+    const Obstacle* begin;
+    const Obstacle* end;
 
-        if (obstacle.type == Obstacle::Type::Horizontal)
+    if (velocity.y != 0.0f)
+    {
+        const float sweepY = charBorderY + velocity.y * deltaTime;
+        world.getObstaclesInRange(Obstacle::Type::Horizontal, fminf(charBorderY, sweepY), fmaxf(charBorderY, sweepY), begin, end);
+        for (const Obstacle* obstacle = begin; obstacle != end; obstacle++)
         {
-            if (velocity.y == 0.0f)
-            {
-                continue;
-            }
-
             // X overlap check
-            if (!collisionAxisCheck(charX1, charX2, obstacle, segmentIndex))
+            size_t segmentIndex = 0;
+            if (!collisionAxisCheck(charX1, charX2, *obstacle, segmentIndex))
             {
                 continue;
             }
 
             // Compute time until collision in Y
-            float t = (obstacle.perpOffset - charBorderY) / velocity.y;
-            if (t >= 0.0f && t <= deltaTime && t < minimalTimeUntilCollision)
+            float t = (obstacle->perpOffset - charBorderY) / velocity.y;
+            if (t >= 0.0f && t <= deltaTime && t < hitY.time)
             {
-                minimalTimeUntilCollision = t;
-                closestObstacle = &obstacle;
-                closestSegmentIndex = segmentIndex;
+                hitY = { t, obstacle, segmentIndex };
             }
         }
-        else
-        {
-            if (velocity.x == 0.0f)
-            {
-                continue;
-            }
+    }
 
+    if (velocity.x != 0.0f)
+    {
+        const float sweepX = charBorderX + velocity.x * deltaTime;
+        world.getObstaclesInRange(Obstacle::Type::Vertical, fminf(charBorderX, sweepX), fmaxf(charBorderX, sweepX), begin, end);
+        for (const Obstacle* obstacle = begin; obstacle != end; obstacle++)
+        {
             // Y overlap check
-            if (!collisionAxisCheck(charY1, charY2, obstacle, segmentIndex))
+            size_t segmentIndex = 0;
+            if (!collisionAxisCheck(charY1, charY2, *obstacle, segmentIndex))
             {
                 continue;
             }
 
             // Compute time until collision in X
-            float t = (obstacle.perpOffset - charBorderX) / velocity.x;
-            if (t >= 0.0f && t <= deltaTime && t < minimalTimeUntilCollision)
+            float t = (obstacle->perpOffset - charBorderX) / velocity.x;
+            if (t >= 0.0f && t <= deltaTime && t < hitX.time)
             {
-                minimalTimeUntilCollision = t;
-                closestObstacle = &obstacle;
-                closestSegmentIndex = segmentIndex;
+                hitX = { t, obstacle, segmentIndex };
             }
         }
     }
 
-    if (closestObstacle == nullptr)
+    const float firstHitTime = fminf(hitX.time, hitY.time);
+    if (firstHitTime == FLT_MAX)
     {
         // No collision within deltaTime
         position += velocity * deltaTime;
         return 0.0f;
     }
-    else
+
+    // Collision detected
+    position += velocity * firstHitTime;
+
+    if (hitY.obstacle && hitY.time - firstHitTime <= SIMULTANEOUS_CONTACT_TIME)
     {
-        // Collision detected
-        position += velocity * minimalTimeUntilCollision;
-        if (closestObstacle->type == Obstacle::Type::Horizontal)
-        {
-            float elasticity = signVelY > 0.0f ? data.collisionElasticityRoof : data.collisionElasticityFloor;
-            velocity.y *= -elasticity;
-            groundedData.isGrounded = signVelY < 0.0f;
-        }
-        else
+        float elasticity = signVelY > 0.0f ? data.collisionElasticityRoof : data.collisionElasticityFloor;
+        velocity.y *= -elasticity;
+
+        if (signVelY < 0.0f)
         {
-            velocity.x *= -data.collisionElasticitySides;
-            groundedData.isGrounded = false;
+            groundedData.isGrounded = true;
         }
-        groundedData.segmentIndex = closestSegmentIndex;
+    }
 
-        return deltaTime - minimalTimeUntilCollision; // Remaining time to process
+    if (hitX.obstacle && hitX.time - firstHitTime <= SIMULTANEOUS_CONTACT_TIME)
+    {
+        velocity.x *= -data.collisionElasticitySides;
     }
-}
 
+    return deltaTime - firstHitTime; // Remaining time to process
+}
 
 Character::Character(const Vec2& position, const Vec2& size, const Data& data)
     : position(position), size(size), velocity(), data(data)
@@ -136,7 +140,7 @@ Character::~Character()
 }
 
 
-void Character::update(float deltaTime)
+void Character::update(float deltaTime, const WorldSnapshot& world)
 {
     groundedData.isGrounded = false;
     isMovingPurposefully = false;
@@ -145,20 +149,32 @@ void Character::update(float deltaTime)
     if (isBeingDragged)
     {
         velocity = Vec2();
+        carriedTime = 0.0f;
         updateAABB();
+        updateAnimation(deltaTime);
         return;
     }
 
     // Apply gravity
-    // TODO: Make it world setting
-    Vec2 gravity(0.0f, -20.0f);
     velocity += gravity * deltaTime;
 
     // Process collisions within the time step
-    float timeBudget = deltaTime;
-    while (timeBudget > 0.0f)
+    // Time left after the last allowed pass moves the character next update,
+    // at most one step of it so a character wedged in a corner doesn't pile it up
+    float timeBudget = deltaTime + carriedTime;
+    collisionIterations = 0;
+    while (timeBudget > 0.0f && collisionIterations < MAX_COLLISION_ITERATIONS)
+    {
+        timeBudget = collisions(timeBudget, world);
+        collisionIterations++;
+    }
+    carriedTime = fminf(timeBudget, deltaTime);
+
+    // Standing on top of another character counts as ground
+    if (isRestingOnCharacter)
     {
-        timeBudget = collisions(timeBudget);
+        groundedData.isGrounded = true;
+        isRestingOnCharacter = false;
     }
 
     // Follow target
@@ -173,7 +189,7 @@ void Character::update(float deltaTime)
         if (groundedData.isGrounded)
         {
             const float signVelX = copysignf(1.0f, velocity.x);
-            float frictionImpulse = data.frictionFloor;
+            float frictionImpulse = data.frictionFloor * deltaTime;
 
             if (frictionImpulse > fabsf(velocity.x))
             {
@@ -188,6 +204,44 @@ void Character::update(float deltaTime)
 
     // Refresh bounding box after movement
     updateAABB();
+    updateAnimation(deltaTime);
+}
+
+// Picks animation state from the physics state of the last update
+void Character::updateAnimation(float deltaTime)
+{
+    AnimationState newState;
+    if (isBeingDragged)
+    {
+        newState = AnimationState::Drag;
+    }
+    else if (!groundedData.isGrounded)
+    {
+        newState = AnimationState::Fall;
+    }
+    else if (fabsf(velocity.x) > WALK_ANIMATION_MIN_SPEED)
+    {
+        newState = AnimationState::Walk;
+    }
+    else
+    {
+        newState = AnimationState::Idle;
+    }
+
+    if (newState != animationState)
+    {
+        animationState = newState;
+        animationTime = 0.0f;
+    }
+    else
+    {
+        animationTime += deltaTime;
+    }
+
+    if (fabsf(velocity.x) > WALK_ANIMATION_MIN_SPEED)
+    {
+        facingLeft = velocity.x < 0.0f;
+    }
 }
 
 void Character::updateAABB()
@@ -208,6 +262,12 @@ void Character::followTarget(float deltaTime)
     float dpos = targetToFollow.position.x - position.x;
     float sign = copysignf(1.0f, dpos);
 
+    if (targetToFollow.jump && fabsf(dpos) <= JUMP_TAKEOFF_DISTANCE)
+    {
+        velocity = Vec2(targetToFollow.jumpVelocity.x, fminf(targetToFollow.jumpVelocity.y, data.maxJumpVelocity));
+        return;
+    }
+
     float speed = fabsf(dpos / deltaTime);
     speed = fminf(speed, data.maxSpeed);
 
@@ -215,11 +275,90 @@ void Character::followTarget(float deltaTime)
 }
 
 
+// Shortens a move along one axis so the character border stops at the first obstacle line in the way
+// Horizontal obstacles stop moves along Y, vertical ones moves along X
+float Character::clampToObstacles(Obstacle::Type type, float delta, const WorldSnapshot& world) const
+{
+    if (delta == 0.0f)
+    {
+        return 0.0f;
+    }
+
+    const bool alongY = type == Obstacle::Type::Horizontal;
+    const Vec2 halfSize = size * 0.5f;
+    const float center = alongY ? position.y : position.x;
+    const float border = center + (alongY ? halfSize.y : halfSize.x) * copysignf(1.0f, delta);
+    const float crossMin = alongY ? position.x - halfSize.x : position.y - halfSize.y;
+    const float crossMax = alongY ? position.x + halfSize.x : position.y + halfSize.y;
+
+    const Obstacle* begin;
+    const Obstacle* end;
+    world.getObstaclesInRange(type, fminf(border, border + delta), fmaxf(border, border + delta), begin, end);
+    for (const Obstacle* obstacle = begin; obstacle != end; obstacle++)
+    {
+        size_t segmentIndex = 0;
+        if (!collisionAxisCheck(crossMin, crossMax, *obstacle, segmentIndex))
+        {
+            continue;
+        }
+
+        const float allowed = obstacle->perpOffset - border;
+        if (fabsf(allowed) < fabsf(delta))
+        {
+            delta = allowed;
+        }
+    }
+
+    return delta;
+}
+
+// Pushes character out of another character's body
+// Correction points away from the other body. Obstacles stop the push,
+// otherwise a character squeezed against a window side would end up behind it.
+void Character::resolveContact(const Vec2& correction, const WorldSnapshot& world)
+{
+    position.x += clampToObstacles(Obstacle::Type::Vertical, correction.x, world);
+    position.y += clampToObstacles(Obstacle::Type::Horizontal, correction.y, world);
+
+    if (correction.y > 0.0f)
+    {
+        // Landed on top of another character
+        if (velocity.y < 0.0f)
+        {
+            velocity.y *= -data.collisionElasticityFloor;
+        }
+        isRestingOnCharacter = true;
+    }
+    else if (correction.y < 0.0f)
+    {
+        // Hit another character with the head
+        if (velocity.y > 0.0f)
+        {
+            velocity.y *= -data.collisionElasticityRoof;
+        }
+    }
+
+    if (correction.x * velocity.x < 0.0f)
+    {
+        velocity.x *= -data.collisionElasticitySides;
+    }
+
+    updateAABB();
+}
+
+
 void Character::setFollowTarget(const FollowTarget& newTarget)
 {
     targetToFollow = newTarget;
 }
 
+void Character::setAnimation(AnimationState state, float time, bool newFacingLeft)
+{
+    animationState = state;
+    animationTime = time;
+    facingLeft = newFacingLeft;
+}
+
 
 void Character::setPosition(float x, float y)
 {
@@ -264,6 +403,11 @@ const Vec2& Character::getSize() const
     return size;
 }
 
+const Character::Data& Character::getData() const
+{
+    return data;
+}
+
 const Vec2& Character::getVelocity() const
 {
     return velocity;
@@ -273,3 +417,33 @@ const AABB& Character::getAABB() const
 {
     return aabb;
 }
+
+const Character::GroundedData& Character::getGroundedData() const
+{
+    return groundedData;
+}
+
+int Character::getCollisionIterations() const
+{
+    return collisionIterations;
+}
+
+float Character::getCarriedTime() const
+{
+    return carriedTime;
+}
+
+Character::AnimationState Character::getAnimationState() const
+{
+    return animationState;
+}
+
+float Character::getAnimationTime() const
+{
+    return animationTime;
+}
+
+bool Character::isFacingLeft() const
+{
+    return facingLeft;
+}
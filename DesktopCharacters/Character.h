@@ -5,6 +5,7 @@
 #include "Core/AABB.h"
 
 #include "Obstacle.h"
+#include "WorldSnapshot.h"
 
 #include <vector>
 
@@ -21,7 +22,7 @@ public:
         float collisionElasticityRoof = 0.0f;
         float collisionElasticityFloor = 0.0f;
 
-        float frictionFloor = 0.0f;
+        float frictionFloor = 0.0f; // Horizontal deceleration while grounded, per second
 
         // bool canClimb = false;
         // float climbingSpeed = 0.0f;
@@ -31,15 +32,18 @@ public:
     {
         bool exist = false;
         Vec2 position;
+
+        // Jump once position is reached
+        bool jump = false;
+        Vec2 jumpVelocity; // As planned by navigation, vertical part is capped by maxJumpVelocity
     };
 
     struct GroundedData
     {
         bool isGrounded = false;
-        
-        const Obstacle* obstacle = nullptr;
-        size_t segmentIndex = 0;
     };
+
+    enum class AnimationState : char { Idle, Walk, Fall, Drag };
 private:
     Vec2 position;
     Vec2 size;
@@ -52,12 +56,22 @@ private:
     GroundedData groundedData;
 
     bool isMovingPurposefully = false;
+    bool isRestingOnCharacter = false;
+
+    int collisionIterations = 0; // collisions() passes during the last update
+    float carriedTime = 0.0f; // Movement time collisions() passes had no budget left for, used by next update
+
+    // Animation
+    AnimationState animationState = AnimationState::Idle;
+    float animationTime = 0.0f; // Time spent in current state
+    bool facingLeft = false;
 
     bool collisionAxisCheck(float axisMin, float axisMax, const Obstacle& obstacle, size_t& returnSegmentIndex) const;
-    float collisions(float deltaTime);
+    float collisions(float deltaTime, const WorldSnapshot& world);
+    float clampToObstacles(Obstacle::Type type, float delta, const WorldSnapshot& world) const;
+    void updateAnimation(float deltaTime);
 public:
-    static Vec2 worldSize; // Center is at zero
-    static std::vector<Obstacle> obstacles;
+    static Vec2 gravity;
 
     bool isBeingDragged = false;
 
@@ -65,13 +79,17 @@ public:
     ~Character();
 
     //
-    void update(float deltaTime);
+    void update(float deltaTime, const WorldSnapshot& world);
     void updateAABB();
     void followTarget(float deltaTime);
+    void resolveContact(const Vec2& correction, const WorldSnapshot& world);
 
     //
     void setFollowTarget(const FollowTarget& newTarget);
 
+    // Used when restoring saved state
+    void setAnimation(AnimationState state, float time, bool newFacingLeft);
+
     //
     void setPosition(float x, float y);
     void setPosition(const Vec2& newPosition);
@@ -83,6 +101,13 @@ public:
     // Getters
     const Vec2& getPosition() const;
     const Vec2& getSize() const;
+    const Data& getData() const;
     const Vec2& getVelocity() const;
     const AABB& getAABB() const;
+    const GroundedData& getGroundedData() const;
+    int getCollisionIterations() const;
+    float getCarriedTime() const;
+    AnimationState getAnimationState() const;
+    float getAnimationTime() const;
+    bool isFacingLeft() const;
 };
\ No newline at end of file
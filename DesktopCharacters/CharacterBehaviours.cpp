@@ -0,0 +1,288 @@
+#include "CharacterBehaviours.h"
+
+#include "Core/Random.h"
+
+#include <cmath>
+
+using Event = BehaviourScheduler::Event;
+using Platform = NavigationGraph::Platform;
+
+// Closer than this to goal x counts as reached
+static const float REACH_DISTANCE = 0.02f;
+
+// Waits on movement give up after these, characters get pushed, dragged and blocked
+static const float MOVE_TIMEOUT = 6.0f;
+static const float LANDING_TIMEOUT = 4.0f;
+
+static const int MAX_CLIMBS = 3;
+
+namespace
+{
+    Behaviour followMouse(BehaviourContext context, float duration)
+    {
+        context.followMouse();
+        co_await context.seconds(duration);
+        context.stop();
+    }
+
+    // Walks to random spots of the platform it stands on, resting in between
+    Behaviour wander(BehaviourContext context, float duration)
+    {
+        const float end = context.getTime() + duration;
+        while (context.getTime() < end)
+        {
+            // Airborne or standing on another character, just rests
+            const Platform* platform = context.getPlatform();
+            const float margin = context.getCharacter().getSize().x * 0.5f;
+            if (platform != nullptr && platform->x.max - platform->x.min > margin * 2.0f)
+            {
+                context.moveTo(Random::Float(platform->x.min + margin, platform->x.max - margin));
+                co_await context.targetReached(MOVE_TIMEOUT);
+                context.stop();
+            }
+
+            co_await context.seconds(Random::Float(0.5f, 2.0f));
+        }
+    }
+
+    // One jump onto a higher platform, nothing if current one has no jump edges
+    Behaviour climb(BehaviourContext context)
+    {
+        const Platform* platform = context.getPlatform();
+        if (platform == nullptr)
+        {
+            co_return;
+        }
+
+        int jumpsCount = 0;
+        for (const NavigationGraph::Edge& edge : platform->edges)
+        {
+            jumpsCount += edge.type == NavigationGraph::EdgeType::Jump ? 1 : 0;
+        }
+        if (jumpsCount == 0)
+        {
+            co_return;
+        }
+
+        // Platform may be rebuilt while waiting, edge is used right away
+        int pick = Random::Int(0, jumpsCount - 1);
+        for (const NavigationGraph::Edge& edge : platform->edges)
+        {
+            if (edge.type == NavigationGraph::EdgeType::Jump && pick-- == 0)
+            {
+                context.jumpFrom(edge.takeoffX, Vec2(edge.velocityX, edge.velocityY));
+                break;
+            }
+        }
+
+        const bool tookOff = co_await context.airborne(MOVE_TIMEOUT);
+        context.stop();
+        if (tookOff)
+        {
+            co_await context.grounded(LANDING_TIMEOUT);
+        }
+    }
+
+    Behaviour sitOnWindow(BehaviourContext context, float duration)
+    {
+        for (int i = 0; i < MAX_CLIMBS; i++)
+        {
+            const Platform* platform = context.getPlatform();
+            if (platform != nullptr && context.isWindowTop(*platform))
+            {
+                break;
+            }
+            co_await climb(context);
+        }
+
+        const Platform* platform = context.getPlatform();
+        if (platform == nullptr || !context.isWindowTop(*platform))
+        {
+            co_return;
+        }
+
+        context.moveTo((platform->x.min + platform->x.max) * 0.5f);
+        co_await context.targetReached(MOVE_TIMEOUT);
+        context.stop();
+        co_await context.seconds(duration);
+    }
+
+    // Default script, picks another activity whenever one ends
+    Behaviour live(BehaviourContext context)
+    {
+        while (true)
+        {
+            // Also staggers characters added together
+            co_await context.seconds(Random::Float(0.2f, 1.5f));
+
+            const int activity = Random::Int(0, 9);
+            if (activity < 4)
+            {
+                co_await followMouse(context, Random::Float(5.0f, 10.0f));
+            }
+            else if (activity < 7)
+            {
+                co_await wander(context, Random::Float(8.0f, 15.0f));
+            }
+            else
+            {
+                co_await sitOnWindow(context, Random::Float(10.0f, 20.0f));
+            }
+        }
+    }
+}
+
+
+BehaviourContext::BehaviourContext(CharacterBehaviours* behaviours, uint32_t index) :
+    behaviours(behaviours), index(index)
+{
+}
+
+const Character& BehaviourContext::getCharacter() const
+{
+    return *(*behaviours->characters)[index];
+}
+
+const NavigationGraph::Platform* BehaviourContext::getPlatform() const
+{
+    return behaviours->navigation->getStandingPlatform(getCharacter());
+}
+
+bool BehaviourContext::isWindowTop(const NavigationGraph::Platform& platform) const
+{
+    return platform.windowTop;
+}
+
+float BehaviourContext::getTime() const
+{
+    return behaviours->scheduler.getTime();
+}
+
+void BehaviourContext::followMouse()
+{
+    getGoal() = BehaviourGoal();
+    getGoal().type = BehaviourGoal::Type::FollowMouse;
+}
+
+void BehaviourContext::moveTo(float x)
+{
+    getGoal() = BehaviourGoal();
+    getGoal().type = BehaviourGoal::Type::MoveTo;
+    getGoal().x = x;
+}
+
+void BehaviourContext::jumpFrom(float takeoffX, const Vec2& velocity)
+{
+    moveTo(takeoffX);
+    getGoal().jump = true;
+    getGoal().jumpVelocity = velocity;
+}
+
+void BehaviourContext::stop()
+{
+    getGoal() = BehaviourGoal();
+}
+
+BehaviourScheduler::Wait BehaviourContext::seconds(float time)
+{
+    return behaviours->scheduler.waitSeconds(index, time);
+}
+
+BehaviourScheduler::Wait BehaviourContext::grounded(float timeout)
+{
+    const bool happened = CharacterBehaviours::hasHappened(Event::Grounded, getCharacter(), getGoal());
+    return behaviours->scheduler.waitEvent(index, Event::Grounded, happened, timeout);
+}
+
+BehaviourScheduler::Wait BehaviourContext::airborne(float timeout)
+{
+    const bool happened = CharacterBehaviours::hasHappened(Event::Airborne, getCharacter(), getGoal());
+    return behaviours->scheduler.waitEvent(index, Event::Airborne, happened, timeout);
+}
+
+BehaviourScheduler::Wait BehaviourContext::targetReached(float timeout)
+{
+    const bool happened = CharacterBehaviours::hasHappened(Event::TargetReached, getCharacter(), getGoal());
+    return behaviours->scheduler.waitEvent(index, Event::TargetReached, happened, timeout);
+}
+
+BehaviourGoal& BehaviourContext::getGoal() const
+{
+    return behaviours->goals[index];
+}
+
+
+void CharacterBehaviours::start(uint32_t index)
+{
+    if (index >= goals.size())
+    {
+        goals.resize(index + 1);
+        firedEvents.reserve(goals.size());
+    }
+
+    goals[index] = BehaviourGoal();
+    starting.push_back(index);
+}
+
+void CharacterBehaviours::clear()
+{
+    scheduler.clear();
+    goals.clear();
+    firedEvents.clear();
+    starting.clear();
+}
+
+const BehaviourGoal& CharacterBehaviours::getGoal(uint32_t index) const
+{
+    return goals[index];
+}
+
+void CharacterBehaviours::checkEvents(uint32_t index, const Character& character)
+{
+    const Event event = scheduler.getWaitingEvent(index);
+    if (event != Event::None && hasHappened(event, character, goals[index]))
+    {
+        firedEvents.push_back({ index, event });
+    }
+}
+
+void CharacterBehaviours::update(const std::vector<std::unique_ptr<Character>>& newCharacters, const NavigationGraph& newNavigation)
+{
+    characters = &newCharacters;
+    navigation = &newNavigation;
+
+    for (uint32_t index : starting)
+    {
+        scheduler.start(index, live(BehaviourContext(this, index)));
+    }
+    starting.clear();
+
+    for (const FiredEvent& fired : firedEvents)
+    {
+        scheduler.fire(fired.index, fired.event);
+    }
+    firedEvents.clear();
+
+    scheduler.tick();
+}
+
+uint64_t CharacterBehaviours::getResumedCount() const
+{
+    return scheduler.getResumedCount();
+}
+
+bool CharacterBehaviours::hasHappened(BehaviourScheduler::Event event, const Character& character, const BehaviourGoal& goal)
+{
+    const bool isGrounded = character.getGroundedData().isGrounded;
+    switch (event)
+    {
+    case Event::Grounded:
+        return isGrounded;
+    case Event::Airborne:
+        return !isGrounded;
+    case Event::TargetReached:
+        return isGrounded && goal.type == BehaviourGoal::Type::MoveTo && fabsf(character.getPosition().x - goal.x) <= REACH_DISTANCE;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "BehaviourScheduler.h"
+#include "Character.h"
+#include "NavigationGraph.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// What a behaviour asks of its character, turned into a follow target at every update
+struct BehaviourGoal
+{
+    enum class Type : char
+    {
+        Idle,
+        FollowMouse, // Along navigation routes
+        MoveTo       // Straight along current platform
+    };
+
+    Type type = Type::Idle;
+    float x = 0.0f;
+
+    // Jump once x is reached
+    bool jump = false;
+    Vec2 jumpVelocity;
+};
+
+class CharacterBehaviours;
+
+// Handed by value to behaviour coroutines, steers one character
+class BehaviourContext
+{
+public:
+    BehaviourContext(CharacterBehaviours* behaviours, uint32_t index);
+
+    const Character& getCharacter() const;
+    const NavigationGraph::Platform* getPlatform() const; // Under character's feet
+    bool isWindowTop(const NavigationGraph::Platform& platform) const;
+    float getTime() const;
+
+    void followMouse();
+    void moveTo(float x);
+    void jumpFrom(float takeoffX, const Vec2& velocity);
+    void stop();
+
+    BehaviourScheduler::Wait seconds(float time);
+    BehaviourScheduler::Wait grounded(float timeout);
+    BehaviourScheduler::Wait airborne(float timeout);
+    BehaviourScheduler::Wait targetReached(float timeout);
+private:
+    CharacterBehaviours* behaviours;
+    uint32_t index;
+
+    BehaviourGoal& getGoal() const;
+};
+
+// Behaviour scripts of every character: wander, follow the mouse, climb, sit on a window
+// Scripts only run between updates. Updates report events a character waits for,
+// everything else about waiting characters is left to the scheduler.
+class CharacterBehaviours
+{
+public:
+    // Default script of character index starts at next update
+    void start(uint32_t index);
+    void clear();
+
+    const BehaviourGoal& getGoal(uint32_t index) const;
+
+    // Called after character index was updated, never allocates
+    void checkEvents(uint32_t index, const Character& character);
+
+    // Resumes behaviours whose events happened or timers expired
+    void update(const std::vector<std::unique_ptr<Character>>& characters, const NavigationGraph& navigation);
+
+    uint64_t getResumedCount() const;
+private:
+    friend class BehaviourContext;
+
+    struct FiredEvent
+    {
+        uint32_t index;
+        BehaviourScheduler::Event event;
+    };
+
+    BehaviourScheduler scheduler;
+    std::vector<BehaviourGoal> goals; // By character
+    std::vector<FiredEvent> firedEvents; // Since last update, capacity kept for every character
+    std::vector<uint32_t> starting;
+
+    // Valid while behaviours run
+    const std::vector<std::unique_ptr<Character>>* characters = nullptr;
+    const NavigationGraph* navigation = nullptr;
+
+    static bool hasHappened(BehaviourScheduler::Event event, const Character& character, const BehaviourGoal& goal);
+};
@@ -0,0 +1,208 @@
+#include "CharacterCollisions.h"
+
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Sparse characters don't get more cells than this per character
+static const int MAX_CELLS_PER_CHARACTER = 2;
+
+void CharacterCollisions::resolve(std::vector<std::unique_ptr<Character>>& characters, const WorldSnapshot& world)
+{
+    PROFILE_FUNCTION_NO_ALLOC();
+
+    candidatePairsCount = 0;
+    contactsCount = 0;
+
+    buildGrid(characters);
+
+    // Every pair is tested once, against later proxies of the same cell and the right neighbour,
+    // and against the three cells above. Both are contiguous runs of sortedProxies.
+    for (int y = 0; y < cellsY; y++)
+    {
+        for (int x = 0; x < cellsX; x++)
+        {
+            const uint32_t cell = (uint32_t)(y * cellsX + x);
+            const uint32_t rowEnd = cellStarts[x + 1 < cellsX ? cell + 2 : cell + 1];
+
+            uint32_t aboveBegin = 0, aboveEnd = 0;
+            if (y + 1 < cellsY)
+            {
+                const uint32_t aboveCell = cell + (uint32_t)cellsX;
+                aboveBegin = cellStarts[x > 0 ? aboveCell - 1 : aboveCell];
+                aboveEnd = cellStarts[x + 1 < cellsX ? aboveCell + 2 : aboveCell + 1];
+            }
+
+            for (uint32_t i = cellStarts[cell]; i < cellStarts[cell + 1]; i++)
+            {
+                const Proxy& current = sortedProxies[i];
+                testRange(current, i + 1, rowEnd, characters, world);
+                testRange(current, aboveBegin, aboveEnd, characters, world);
+            }
+        }
+    }
+}
+
+size_t CharacterCollisions::getCandidatePairsCount() const
+{
+    return candidatePairsCount;
+}
+
+size_t CharacterCollisions::getContactsCount() const
+{
+    return contactsCount;
+}
+
+// Characters are read through their pointers once, the sweep only touches flat proxy arrays
+void CharacterCollisions::buildGrid(const std::vector<std::unique_ptr<Character>>& characters)
+{
+    const size_t count = characters.size();
+
+    proxies.resize(count);
+    proxyCells.resize(count);
+    sortedProxies.resize(count);
+
+    if (count == 0)
+    {
+        cellsX = 0;
+        cellsY = 0;
+        return;
+    }
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float largest = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        const AABB& aabb = characters[i]->getAABB();
+        proxies[i] = { aabb.minX, aabb.maxX, aabb.minY, aabb.maxY, (uint32_t)i };
+
+        // std::min/max compile to single instructions, fminf/fmaxf are NaN-aware library calls
+        minX = std::min(minX, aabb.minX);
+        minY = std::min(minY, aabb.minY);
+        maxX = std::max(maxX, aabb.minX);
+        maxY = std::max(maxY, aabb.minY);
+        largest = std::max(largest, std::max(aabb.maxX - aabb.minX, aabb.maxY - aabb.minY));
+    }
+
+    // Larger cells when characters are spread thin, grid memory follows character count
+    const float width = maxX - minX;
+    const float height = maxY - minY;
+    const float cellsLimit = (float)(count * MAX_CELLS_PER_CHARACTER);
+    cellSize = fmaxf(largest, 1e-6f);
+    while ((width / cellSize + 1.0f) * (height / cellSize + 1.0f) > cellsLimit)
+    {
+        cellSize *= 2.0f;
+    }
+
+    originX = minX;
+    originY = minY;
+    cellsX = (int)(width / cellSize) + 1;
+    cellsY = (int)(height / cellSize) + 1;
+
+    // Counting sort by cell, stable so results don't depend on anything but character order
+    cellStarts.assign((size_t)cellsX * cellsY + 1, 0);
+    const float invCellSize = 1.0f / cellSize;
+    for (size_t i = 0; i < count; i++)
+    {
+        const int x = std::min((int)((proxies[i].minX - originX) * invCellSize), cellsX - 1);
+        const int y = std::min((int)((proxies[i].minY - originY) * invCellSize), cellsY - 1);
+        proxyCells[i] = (uint32_t)(y * cellsX + x);
+        cellStarts[proxyCells[i] + 1]++;
+    }
+
+    for (size_t cell = 1; cell < cellStarts.size(); cell++)
+    {
+        cellStarts[cell] += cellStarts[cell - 1];
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // cellStarts[cell] is used as the write position and ends up as the start of the next cell
+        sortedProxies[cellStarts[proxyCells[i]]++] = proxies[i];
+    }
+
+    for (size_t cell = cellStarts.size() - 1; cell > 0; cell--)
+    {
+        cellStarts[cell] = cellStarts[cell - 1];
+    }
+    cellStarts[0] = 0;
+}
+
+void CharacterCollisions::testRange(const Proxy& proxy, uint32_t begin, uint32_t end, std::vector<std::unique_ptr<Character>>& characters, const WorldSnapshot& world)
+{
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const Proxy& other = sortedProxies[i];
+        // Most tests miss, evaluating all four comparisons avoids a mispredicted branch per comparison
+        const bool overlaps = (other.minX < proxy.maxX) & (proxy.minX < other.maxX) &
+            (other.minY < proxy.maxY) & (proxy.minY < other.maxY);
+        if (!overlaps)
+        {
+            continue;
+        }
+
+        candidatePairsCount++;
+        resolvePair(*characters[proxy.index], *characters[other.index], world);
+    }
+}
+
+// Separates two overlapping characters along the axis of least penetration
+void CharacterCollisions::resolvePair(Character& a, Character& b, const WorldSnapshot& world)
+{
+    // Bounds may have moved since proxies were built
+    const AABB& boxA = a.getAABB();
+    const AABB& boxB = b.getAABB();
+
+    const float overlapX = fminf(boxA.maxX, boxB.maxX) - fmaxf(boxA.minX, boxB.minX);
+    const float overlapY = fminf(boxA.maxY, boxB.maxY) - fmaxf(boxA.minY, boxB.minY);
+
+    if (overlapX <= 0.0f || overlapY <= 0.0f)
+    {
+        return;
+    }
+
+    // Dragged characters can't be pushed
+    float weightA = a.isBeingDragged ? 0.0f : 1.0f;
+    float weightB = b.isBeingDragged ? 0.0f : 1.0f;
+
+    Vec2 direction; // From A to B
+    float penetration;
+
+    if (overlapY < overlapX)
+    {
+        direction = Vec2(0.0f, a.getPosition().y < b.getPosition().y ? 1.0f : -1.0f);
+        penetration = overlapY;
+
+        // Supporting character stays in place, so stacks don't get pushed through the floor
+        Character& lower = direction.y > 0.0f ? a : b;
+        Character& upper = direction.y > 0.0f ? b : a;
+        if (lower.getGroundedData().isGrounded && !upper.isBeingDragged)
+        {
+            (direction.y > 0.0f ? weightA : weightB) = 0.0f;
+        }
+    }
+    else
+    {
+        direction = Vec2(a.getPosition().x < b.getPosition().x ? 1.0f : -1.0f, 0.0f);
+        penetration = overlapX;
+    }
+
+    const float totalWeight = weightA + weightB;
+    if (totalWeight <= 0.0f)
+    {
+        return;
+    }
+
+    contactsCount++;
+
+    if (weightA > 0.0f)
+    {
+        a.resolveContact(direction * (-penetration * weightA / totalWeight), world);
+    }
+    if (weightB > 0.0f)
+    {
+        b.resolveContact(direction * (penetration * weightB / totalWeight), world);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Character.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Character versus character collision pass
+// Broadphase is a uniform grid rebuilt every step with a counting sort. Cells are at least
+// as large as the largest character, so overlapping characters are in neighbouring cells.
+class CharacterCollisions
+{
+public:
+    // Pushes never move characters through obstacles of world
+    void resolve(std::vector<std::unique_ptr<Character>>& characters, const WorldSnapshot& world);
+
+    // Statistics of the last resolve() call
+    size_t getCandidatePairsCount() const;
+    size_t getContactsCount() const;
+private:
+    struct Proxy
+    {
+        float minX, maxX, minY, maxY;
+        uint32_t index;
+    };
+
+    // Grid covers the bounds of all proxies
+    float cellSize = 0.0f;
+    float originX = 0.0f, originY = 0.0f;
+    int cellsX = 0, cellsY = 0;
+
+    std::vector<Proxy> proxies; // By character
+    std::vector<uint32_t> proxyCells; // Cell of each proxy's min corner
+    std::vector<uint32_t> cellStarts; // First proxy of each cell in sortedProxies, one extra at the end
+    std::vector<Proxy> sortedProxies; // Grouped by cell, cells row by row
+
+    size_t candidatePairsCount = 0;
+    size_t contactsCount = 0;
+
+    void buildGrid(const std::vector<std::unique_ptr<Character>>& characters);
+    void testRange(const Proxy& proxy, uint32_t begin, uint32_t end, std::vector<std::unique_ptr<Character>>& characters, const WorldSnapshot& world);
+    void resolvePair(Character& a, Character& b, const WorldSnapshot& world);
+};
@@ -0,0 +1,129 @@
+#include "CharacterLOD.h"
+
+#include "Core/Profiler.h"
+
+CharacterLOD::CharacterLOD(const Settings& settings) :
+    settings(settings)
+{
+}
+
+void CharacterLOD::setDistanceScale(float scale)
+{
+    distanceScale = scale;
+}
+
+void CharacterLOD::schedule(const std::vector<std::unique_ptr<Character>>& characters, const WorldSnapshot& world, const Vec2& target, float stepTime)
+{
+    PROFILE_FUNCTION();
+
+    step++;
+
+    // Characters were removed, indices in buckets may be past the end, so everyone starts over as new
+    if (characters.size() < states.size())
+    {
+        states.clear();
+        for (std::vector<uint32_t>& bucket : buckets)
+        {
+            bucket.clear();
+        }
+        for (size_t& count : tierCounts)
+        {
+            count = 0;
+        }
+    }
+
+    // New characters
+    while (states.size() < characters.size())
+    {
+        State state;
+        state.lastStep = step - 1;
+
+        buckets[step % BUCKETS_COUNT].push_back((uint32_t)states.size());
+        tierCounts[(int)state.tier]++;
+        states.push_back(state);
+    }
+
+    // Bucket is refilled below by characters whose next step lands on it again
+    due.clear();
+    due.swap(buckets[step % BUCKETS_COUNT]);
+
+    dueTimes.resize(due.size());
+    for (size_t i = 0; i < due.size(); i++)
+    {
+        const uint32_t index = due[i];
+        State& state = states[index];
+
+        dueTimes[i] = (float)(step - state.lastStep) * stepTime;
+        state.lastStep = step;
+
+        // Tier is chosen before stepping, so it also sets when this character is due next
+        Tier tier = chooseTier(*characters[index], world, target);
+        tierCounts[(int)state.tier]--;
+        tierCounts[(int)tier]++;
+        state.tier = tier;
+
+        buckets[(step + getPeriod(tier)) % BUCKETS_COUNT].push_back(index);
+    }
+}
+
+const std::vector<uint32_t>& CharacterLOD::getDue() const
+{
+    return due;
+}
+
+float CharacterLOD::getDueTime(size_t dueIndex) const
+{
+    return dueTimes[dueIndex];
+}
+
+size_t CharacterLOD::getTierCount(Tier tier) const
+{
+    return tierCounts[(int)tier];
+}
+
+float CharacterLOD::getLongestStepTime(float stepTime)
+{
+    return stepTime * (float)getPeriod(Tier::Low);
+}
+
+CharacterLOD::Tier CharacterLOD::chooseTier(const Character& character, const WorldSnapshot& world, const Vec2& target) const
+{
+    if (character.isBeingDragged)
+    {
+        return Tier::High;
+    }
+
+    // Outside of screen, nobody sees it
+    if (!world.bounds.isIntersecting(character.getAABB()))
+    {
+        return Tier::Low;
+    }
+
+    const float distanceSquared = Vec2::distanceSquared(character.getPosition(), target);
+    const float nearDistance = settings.nearDistance * distanceScale;
+    if (distanceSquared < nearDistance * nearDistance)
+    {
+        return Tier::High;
+    }
+
+    const float farDistance = settings.farDistance * distanceScale;
+    if (distanceSquared < farDistance * farDistance || character.getVelocity().lengthSquared() > settings.activeSpeed * settings.activeSpeed)
+    {
+        return Tier::Medium;
+    }
+
+    return Tier::Low;
+}
+
+int CharacterLOD::getPeriod(Tier tier)
+{
+    switch (tier)
+    {
+    case Tier::High:
+        return 1;
+    case Tier::Medium:
+        return 2;
+    default:
+        return 4;
+    }
+}
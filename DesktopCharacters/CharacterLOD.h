@@ -0,0 +1,70 @@
+#pragma once
+#include "Character.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Per-character simulation level of detail
+// Characters step at 60, 30 or 15 Hz depending on their tier. Each one waits in the bucket
+// of the step it is due at, so a step only touches characters that are due, and a character
+// gets all the time that passed since its own previous step.
+class CharacterLOD
+{
+public:
+    enum class Tier : char
+    {
+        High,   // Every step
+        Medium, // Every 2nd step
+        Low,    // Every 4th step
+        Count
+    };
+
+    struct Settings
+    {
+        float nearDistance = 1.0f;  // Closer to follow target -> High
+        float farDistance = 2.5f;   // Closer to follow target -> at least Medium
+        float activeSpeed = 0.5f;   // Faster -> at least Medium
+    };
+
+    CharacterLOD() = default;
+    explicit CharacterLOD(const Settings& settings);
+
+    // Scale below 1 shrinks tier distances, so fewer characters step at full rate
+    void setDistanceScale(float scale);
+
+    // Picks characters due at this step, with their accumulated time
+    // Characters added since last call are due right away, removing any reschedules all of them
+    void schedule(const std::vector<std::unique_ptr<Character>>& characters, const WorldSnapshot& world, const Vec2& target, float stepTime);
+
+    // Valid until next schedule()
+    const std::vector<uint32_t>& getDue() const;
+    float getDueTime(size_t dueIndex) const;
+
+    size_t getTierCount(Tier tier) const;
+
+    // Time a character gets in one update at the lowest tier
+    static float getLongestStepTime(float stepTime);
+private:
+    static constexpr int BUCKETS_COUNT = 4; // Every tier period divides it
+
+    struct State
+    {
+        Tier tier = Tier::High;
+        uint64_t lastStep = 0;
+    };
+
+    Settings settings;
+    float distanceScale = 1.0f;
+
+    uint64_t step = 0;
+    std::vector<State> states;
+    std::vector<uint32_t> buckets[BUCKETS_COUNT];
+
+    std::vector<uint32_t> due;
+    std::vector<float> dueTimes;
+    size_t tierCounts[(int)Tier::Count] = {};
+
+    Tier chooseTier(const Character& character, const WorldSnapshot& world, const Vec2& target) const;
+    static int getPeriod(Tier tier);
+};
@@ -0,0 +1,146 @@
+#include "CharacterSpatialHash.h"
+
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+CharacterSpatialHash::CharacterSpatialHash(float cellSize) :
+    cellSize(cellSize), invCellSize(1.0f / cellSize)
+{
+}
+
+void CharacterSpatialHash::update(const std::vector<std::unique_ptr<Character>>& characters)
+{
+    PROFILE_FUNCTION();
+
+    const size_t count = characters.size();
+
+    // Characters were removed -> start from scratch
+    if (count < ranges.size())
+    {
+        cells.clear();
+        ranges.clear();
+        boxes.clear();
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const AABB box = characters[i]->getAABB();
+        const CellRange range = getRange(box);
+
+        if (i == ranges.size())
+        {
+            ranges.push_back(range);
+            boxes.push_back(box);
+            insert((uint32_t)i, range);
+            continue;
+        }
+
+        boxes[i] = box;
+        if (ranges[i] == range)
+        {
+            continue;
+        }
+
+        remove((uint32_t)i, ranges[i]);
+        insert((uint32_t)i, range);
+        ranges[i] = range;
+    }
+}
+
+void CharacterSpatialHash::queryPoint(const Vec2& point, std::vector<uint32_t>& result) const
+{
+    result.clear();
+
+    auto it = cells.find(getKey(toCell(point.x), toCell(point.y)));
+    if (it == cells.end())
+    {
+        return;
+    }
+
+    for (uint32_t index : it->second)
+    {
+        if (boxes[index].isContaining(point))
+        {
+            result.push_back(index);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), std::greater<uint32_t>());
+}
+
+void CharacterSpatialHash::queryRect(const AABB& rect, std::vector<uint32_t>& result) const
+{
+    result.clear();
+
+    const CellRange range = getRange(rect);
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            auto it = cells.find(getKey(x, y));
+            if (it == cells.end())
+            {
+                continue;
+            }
+
+            for (uint32_t index : it->second)
+            {
+                if (boxes[index].isIntersecting(rect))
+                {
+                    result.push_back(index);
+                }
+            }
+        }
+    }
+
+    // Characters spanning several cells were found more than once
+    std::sort(result.begin(), result.end(), std::greater<uint32_t>());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+int CharacterSpatialHash::toCell(float coordinate) const
+{
+    return (int)floorf(coordinate * invCellSize);
+}
+
+CharacterSpatialHash::CellRange CharacterSpatialHash::getRange(const AABB& box) const
+{
+    return { toCell(box.minX), toCell(box.minY), toCell(box.maxX), toCell(box.maxY) };
+}
+
+uint64_t CharacterSpatialHash::getKey(int x, int y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+void CharacterSpatialHash::insert(uint32_t index, const CellRange& range)
+{
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            cells[getKey(x, y)].push_back(index);
+        }
+    }
+}
+
+void CharacterSpatialHash::remove(uint32_t index, const CellRange& range)
+{
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            // Cells are small, order inside a cell doesn't matter
+            std::vector<uint32_t>& cell = cells[getKey(x, y)];
+            auto it = std::find(cell.begin(), cell.end(), index);
+            if (it != cell.end())
+            {
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
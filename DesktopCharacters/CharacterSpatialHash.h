@@ -0,0 +1,46 @@
+#pragma once
+#include "Character.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Hashed uniform grid over character AABBs, used for picking
+// A character is moved between cells only when the range of cells it covers changes.
+// Query results are character indices, top-most first (characters drawn later are on top).
+class CharacterSpatialHash
+{
+public:
+    explicit CharacterSpatialHash(float cellSize = 0.5f);
+
+    void update(const std::vector<std::unique_ptr<Character>>& characters);
+
+    // Boxes are the ones seen by last update()
+    void queryPoint(const Vec2& point, std::vector<uint32_t>& result) const;
+    void queryRect(const AABB& rect, std::vector<uint32_t>& result) const;
+private:
+    struct CellRange
+    {
+        int minX, minY, maxX, maxY;
+
+        bool operator==(const CellRange& other) const
+        {
+            return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+        }
+    };
+
+    float cellSize;
+    float invCellSize;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<CellRange> ranges; // Cells each character is currently in
+    std::vector<AABB> boxes;
+
+    int toCell(float coordinate) const;
+    CellRange getRange(const AABB& box) const;
+    static uint64_t getKey(int x, int y);
+
+    void insert(uint32_t index, const CellRange& range);
+    void remove(uint32_t index, const CellRange& range);
+};
@@ -1,54 +1,106 @@
 #include "CharactersManager.h"
 
+#include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <thread>
 
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+
+#include "Core/AABBx8.h"
 #include "Core/Profiler.h"
+#include "Core/Random.h"
 
-std::wstring getSafeString(const std::wstring& original)
-{
-    size_t length = original.size();
-    std::wstring safe = original;
+// Simulation step, characters further away are updated less often by CharacterLOD
+static const float UPDATE_PERIOD = 1.0f / 60.0f;
 
-    for (size_t i = 0; i < length; i++)
+// Windows slower than this are treated as standing still, in world units per second
+static const float WINDOW_MOVING_SPEED = 1e-3f;
+
+// Edges closer than this are treated as lying on the same line, well below a pixel in world units
+static const float OBSTACLE_COALESCE_EPSILON = 1e-4f;
+
+// Simulation state saved for next run
+static const char* STATE_PATH = "simulation.sav";
+static const float STATE_SAVE_PERIOD = 5.0f; // In seconds
+
+// Mouse events are captured, the rest of window events don't depend on the desktop
+static bool toInputEvent(const WindowEvent& evt, InputEvent& event)
+{
+    switch (evt.type)
     {
-        wchar_t ch = original[i];
-        if (ch < 32 || ch > 255)
-        {
-            safe[i] = L'?';
-        }
+    case WindowEvent::Type::LeftMouseDown:
+        event.type = InputEvent::Type::LeftMouseDown;
+        break;
+    case WindowEvent::Type::LeftMouseUp:
+        event.type = InputEvent::Type::LeftMouseUp;
+        break;
+    case WindowEvent::Type::MouseMove:
+        event.type = InputEvent::Type::MouseMove;
+        break;
+    default:
+        return false;
     }
-    return safe;
+
+    event.x = evt.localMouseX;
+    event.y = evt.localMouseY;
+    return true;
 }
 
-void splitSegment(const Range& a, const Range& b, std::vector<Range>& result)
+static WindowEvent toWindowEvent(const InputEvent& event)
 {
-    float left = fmaxf(a.min, b.min);
-    float right = fminf(a.max, b.max);
-
-    // If no overlap
-    if (left >= right)
+    WindowEvent evt;
+    switch (event.type)
     {
-        result.push_back({ a.min, a.max });
-        return;
+    case InputEvent::Type::LeftMouseDown:
+        evt.type = WindowEvent::Type::LeftMouseDown;
+        break;
+    case InputEvent::Type::LeftMouseUp:
+        evt.type = WindowEvent::Type::LeftMouseUp;
+        break;
+    case InputEvent::Type::MouseMove:
+        evt.type = WindowEvent::Type::MouseMove;
+        break;
     }
 
-    // Left piece
-    if (a.min < left)
+    evt.localMouseX = event.x;
+    evt.localMouseY = event.y;
+    return evt;
+}
+
+// Empty if the path doesn't fit, files are then looked up in working directory
+static std::filesystem::path getExecutableDirectory()
+{
+    wchar_t path[MAX_PATH];
+    const DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    if (length == 0 || length == MAX_PATH)
     {
-        result.push_back({ a.min, left });
+        return std::filesystem::path();
     }
+    return std::filesystem::path(path).parent_path();
+}
+
+std::wstring getSafeString(const std::wstring& original)
+{
+    size_t length = original.size();
+    std::wstring safe = original;
 
-    // Right piece
-    if (right < a.max)
+    for (size_t i = 0; i < length; i++)
     {
-        result.push_back({ right, a.max });
+        wchar_t ch = original[i];
+        if (ch < 32 || ch > 255)
+        {
+            safe[i] = L'?';
+        }
     }
+    return safe;
 }
 
 void splitObstacleByAABB(Obstacle& obstacle, const AABB& occluder)
 {
-    std::vector<Range> newSegments;
-
     Range occluderSegment;
     if (obstacle.type == Obstacle::Type::Horizontal)
     {
@@ -71,12 +123,7 @@ void splitObstacleByAABB(Obstacle& obstacle, const AABB& occluder)
         occluderSegment.max = occluder.maxY;
     }
 
-    for (auto& segment : obstacle.segments)
-    {
-        splitSegment(segment, occluderSegment, newSegments);
-    }
-
-    obstacle.segments = std::move(newSegments);
+    obstacle.segments.subtract(occluderSegment);
 }
 
 
@@ -86,20 +133,82 @@ CharactersManager::CharactersManager() : shouldExit(false)
 
 CharactersManager::~CharactersManager()
 {
+    stopWorldBuilder();
+
+    // Clock captures platform interface
+    Profiler::setClock(nullptr);
+
     characters.clear();
 }
 
+void CharactersManager::setCapturePath(const std::string& path)
+{
+    capturePath = path;
+}
+
+void CharactersManager::setReplay(const std::string& path, double startSeconds, double speed, bool fixedStep)
+{
+    replayPath = path;
+    replayStartSeconds = startSeconds;
+    replaySpeed = speed;
+    replayFixedStep = fixedStep;
+}
+
 bool CharactersManager::initialize()
 {
-    // Platform
-    platformInterface = std::make_unique<PlatformInterfaceClass>();
+    // Platform, replay stands in for the desktop and recording wraps whichever is used
+    if (!replayPath.empty())
+    {
+        auto replayInterface = std::make_unique<Replay_PlatformInterface>();
+        if (!replayInterface->open(replayPath, replayStartSeconds, replaySpeed))
+        {
+            return false;
+        }
+        replay = replayInterface.get();
+        platformInterface = std::move(replayInterface);
+    }
+    else
+    {
+        platformInterface = std::make_unique<PlatformInterfaceClass>();
+    }
+
+    if (!capturePath.empty())
+    {
+        auto recordingInterface = std::make_unique<Recording_PlatformInterface>(std::move(platformInterface));
+        if (!recordingInterface->open(capturePath))
+        {
+            return false;
+        }
+        recorder = recordingInterface.get();
+        platformInterface = std::move(recordingInterface);
+    }
+
     platformInterface->start();
 
+    // Fixed step replay doesn't depend on how long steps take, so it gives same result on every run
+    // Zones are then left on real clock, fake one doesn't move during a step
+    if (replay != nullptr && replayFixedStep)
+    {
+        replay->setFakeClockEnabled(true);
+    }
+    else
+    {
+        // Zones are measured with same clock as simulation
+        Profiler::setClock([this]() { return platformInterface->getTimeNanoseconds(); });
+    }
+
     int scrW = 0, scrH = 0;
     platformInterface->getScreenResolution(scrW, scrH);
     screenSize = Vec2(scrW, scrH);
 
-    Character::worldSize = Vec2((float)scrW / (float)scrH, 1.0f) * 2.5f;
+    worldSize = Vec2((float)scrW / (float)scrH, 1.0f) * 2.5f;
+    updateTransforms();
+
+    // World without windows until first poll
+    publishWorld(buildWorld({}, worldSize, worldVersion));
+
+    // Metrics, written in release builds too, where there is no console
+    metrics.open("metrics.prom");
 
     // Main window
     InitWindowParams params;
@@ -120,48 +229,128 @@ bool CharactersManager::initialize()
         return false;
     }
 
-    mainWindow->setCallback([this](const WindowEvent& evt) {
-        this->onWindowEvent(evt);
-        });
+    mainWindow->setEventQueue(&windowEvents, platformInterface.get());
 
     return true;
 }
 
+// Without atlas characters are drawn as rectangles
+// Assets are copied next to the executable, working directory doesn't matter
+void CharactersManager::loadSprites()
+{
+    if (!spriteAtlas.load(getExecutableDirectory() / "Assets" / "characters.atlas"))
+    {
+        return;
+    }
+
+    if (!mainWindow->getRenderer()->loadSpriteAtlas(spriteAtlas.getImagePath()))
+    {
+        std::cout << "Failed to decode sprite atlas image" << std::endl;
+        return;
+    }
+
+    const char* names[] = { "idle", "walk", "fall", "drag" };
+    for (int i = 0; i < 4; i++)
+    {
+        animationIndices[i] = spriteAtlas.getAnimationIndex(names[i]);
+    }
+
+    // Missing states fall back to idle
+    for (int& index : animationIndices)
+    {
+        if (index == -1)
+        {
+            index = animationIndices[0] != -1 ? animationIndices[0] : 0;
+        }
+    }
+}
+
 bool CharactersManager::addCharacter(const Vec2& position, const Vec2& velocity, const Character::Data& charData)
 {
     Vec2 size(0.5f, 0.5f);
 
+    navigation.fitCharacter(size, charData, CharacterLOD::getLongestStepTime(UPDATE_PERIOD));
+
     auto character = std::make_unique<Character>(position, size, charData);
     character->setVelocity(velocity);
     characters.push_back(std::move(character));
 
+    behaviours.start((uint32_t)characters.size() - 1);
+
     return true;
 }
 
+void CharactersManager::enableCrowd(const Crowd::Data& crowdData)
+{
+    crowd = std::make_unique<Crowd>(crowdData);
+    crowd->setThreadCount(std::thread::hardware_concurrency());
+}
+
+bool CharactersManager::addCrowdBody(const Vec2& position, const Vec2& velocity)
+{
+    if (!crowd)
+    {
+        return false;
+    }
+
+    crowd->addBody(position, velocity);
+    return true;
+}
+
+void CharactersManager::setCharacterCollisionsEnabled(bool enabled)
+{
+    characterCollisionsEnabled = enabled;
+}
+
 int CharactersManager::runLoop()
 {
     std::cout << "Program is running. Press Ctrl+Shift+Q to exit." << std::endl;
     std::cout << "Click and drag characters to move them around!" << std::endl;
 
     MSG msg;
-    auto lastTime = GetTickCount64();
+    uint64_t lastTime = platformInterface->getTimeNanoseconds();
 
     float updatesCounter = 0.0f;
     float profilerCounter = 0.0f;
+    float metricsCounter = 0.0f;
+    float stateCounter = 0.0f;
+
+    const float updatePeriod = UPDATE_PERIOD;
+    const bool fixedStep = replay != nullptr && replayFixedStep;
 
-    float updatePeriod = 1.0f / 60.0f;
+    // Without either, Windows sleeps in 15.6 ms ticks and steps come in bursts
+    stepTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (stepTimer == nullptr)
+    {
+        timerPeriodRaised = timeBeginPeriod(1) == TIMERR_NOERROR;
+        stepTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+
+    // Rendering runs on its own thread and only sees published snapshots
+    publishSnapshot();
+    renderThread = std::thread(&CharactersManager::renderLoop, this);
 
     while (!shouldExit)
     {
         Profiler::beginFrame();
 
+        updateTransforms();
+
+        // Fixed step replay runs as fast as it can, one step per iteration
+        if (fixedStep)
+        {
+            replay->advanceFakeClock((uint64_t)(updatePeriod * 1e9f));
+        }
+
         // Calculate delta time
-        auto currentTime = GetTickCount64();
-        float deltaTime = (currentTime - lastTime) * 0.001f; // Convert to seconds
+        uint64_t currentTime = platformInterface->getTimeNanoseconds();
+        float deltaTime = (float)((currentTime - lastTime) * 1e-9); // Convert to seconds
         lastTime = currentTime;
 
         updatesCounter += deltaTime;
         profilerCounter += deltaTime;
+        metricsCounter += deltaTime;
+        stateCounter += deltaTime;
 
         // Check for messages
         {
@@ -171,6 +360,20 @@ int CharactersManager::runLoop()
                 TranslateMessage(&msg);
                 DispatchMessage(&msg);
             }
+            pollWindowEvents();
+
+            InputEvent inputEvent;
+            while (replay != nullptr && replay->pollEvent(inputEvent))
+            {
+                if (recorder != nullptr)
+                {
+                    recorder->recordEvent(inputEvent);
+                }
+
+                WindowEvent evt = toWindowEvent(inputEvent);
+                evt.timestamp = platformInterface->getTimeSeconds();
+                onWindowEvent(evt);
+            }
         }
 
         // Check for exit key combination
@@ -182,23 +385,31 @@ int CharactersManager::runLoop()
         }
 
         // Updates
+        bool updated = false;
         while (updatesCounter > updatePeriod)
         {
             update(updatePeriod);
             updatesCounter -= updatePeriod;
+            stepsCount++;
+            updated = true;
         }
 
+        if (updated)
         {
-            PROFILE_SCOPE("Before render");
-            mainWindow->getRenderer()->beforeRender();
-        }
-        {
-            PROFILE_SCOPE("Render");
-            render();
+            {
+                PROFILE_SCOPE("Publish snapshot");
+                publishSnapshot();
+            }
+            framesCount++;
+
+            // Only iterations that stepped are frames, idle ones are restarted by next beginFrame()
+            Profiler::endFrame();
         }
+
+        // Quality, kept as is in fixed step replay since governor reacts to real frame times
+        if (!fixedStep && qualityGovernor.update(deltaTime))
         {
-            PROFILE_SCOPE("After render");
-            mainWindow->getRenderer()->afterRender();
+            onQualityLevelChanged();
         }
 
         // Profiler
@@ -210,12 +421,124 @@ int CharactersManager::runLoop()
             Profiler::resetAllProfiles();
         }
 
-        Profiler::endFrame();
+        // Metrics
+        if (metricsCounter >= 10.0f)
+        {
+            metricsCounter -= 10.0f;
+            exportMetrics();
+        }
+
+        // Saved state
+        if (stateCounter >= STATE_SAVE_PERIOD)
+        {
+            stateCounter -= STATE_SAVE_PERIOD;
+            saveState(false);
+        }
+
+        if (!updated)
+        {
+            // Nothing to do until next step
+            waitForNextStep(updatePeriod - updatesCounter);
+        }
+    }
+
+    // Wakes render thread so it sees shouldExit
+    publishedSnapshotsCount++;
+    publishedSnapshotsCount.notify_all();
+    renderThread.join();
+
+    if (stepTimer != nullptr)
+    {
+        CloseHandle(stepTimer);
+        stepTimer = nullptr;
+    }
+    if (timerPeriodRaised)
+    {
+        timeEndPeriod(1);
+        timerPeriodRaised = false;
     }
 
+    saveState(true);
+
     return 0;
 }
 
+// Sleeps until next step is due or a message arrives, whichever comes first
+void CharactersManager::waitForNextStep(float seconds)
+{
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(LONGLONG)(seconds * 1e7f); // Relative, in 100 ns units
+
+    if (stepTimer == nullptr || !SetWaitableTimer(stepTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+    {
+        Sleep(1);
+        return;
+    }
+
+    MsgWaitForMultipleObjects(1, &stepTimer, FALSE, INFINITE, QS_ALLINPUT);
+}
+
+void CharactersManager::renderLoop()
+{
+    // Renderer resources belong to this thread, image decoding needs COM in its apartment
+    const bool comInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED));
+    loadSprites();
+
+    BaseRenderer* renderer = mainWindow->getRenderer();
+    uint64_t seenSnapshotsCount = 0;
+    while (!shouldExit)
+    {
+        if (!frameSnapshots.acquire())
+        {
+            // Nothing new to draw, sleeps until next publish
+            publishedSnapshotsCount.wait(seenSnapshotsCount);
+            seenSnapshotsCount = publishedSnapshotsCount.load();
+            continue;
+        }
+
+        const FrameSnapshot& frame = frameSnapshots.getReadBuffer();
+        const auto frameStart = std::chrono::steady_clock::now();
+
+        {
+            PROFILE_SCOPE("Render thread: before render");
+            renderer->beforeRender();
+        }
+        {
+            PROFILE_SCOPE("Render thread: render");
+            render(frame);
+        }
+        {
+            PROFILE_SCOPE("Render thread: after render");
+            renderer->afterRender();
+        }
+
+        const std::chrono::duration<double, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+        qualityGovernor.addRenderFrameTime(frameTime.count());
+    }
+
+    // COM objects go before their apartment does
+    renderer->releaseSpriteAtlas();
+    if (comInitialized)
+    {
+        CoUninitialize();
+    }
+}
+
+
+// Rects of windows timeAhead seconds after last poll, from their filtered motion
+void CharactersManager::extrapolateWindows(float timeAhead)
+{
+    PROFILE_FUNCTION();
+
+    for (auto& window : inGameWindowsData)
+    {
+        const AABB& measured = window.measuredAABB;
+        const Vec2 position = window.motion.predict(timeAhead);
+
+        window.aabb = AABB(position, position + Vec2(measured.maxX - measured.minX, measured.maxY - measured.minY));
+        window.occluded = false;
+    }
+}
 
 void CharactersManager::collectWindowsData(float deltaTime)
 {
@@ -238,6 +561,7 @@ void CharactersManager::collectWindowsData(float deltaTime)
 
         std::vector<InGameWindowData> newInGameWindowsData;
         newInGameWindowsData.reserve(windowsData.size());
+        windowsMoving = false;
 
         for (const WindowData& newData : windowsData)
         {
@@ -266,21 +590,22 @@ void CharactersManager::collectWindowsData(float deltaTime)
             
             cached.occluded = false;
 
+            cached.measuredAABB = cached.aabb;
+
             if (it != windowMap.end())
             {
-                // Window exists, calculate velocity
-                const auto& oldCached = inGameWindowsData[it->second];
-                Vec2 oldPos = { oldCached.aabb.minX, oldCached.aabb.maxX };
-
-                cached.velocity = (newPosition - oldPos) / deltaTime;
+                // Window exists, filter its motion
+                cached.motion = inGameWindowsData[it->second].motion;
+                cached.motion.update(newPosition, deltaTime);
             }
             else
             {
                 // New window
-                cached.velocity = Vec2(0.0f, 0.0f);
+                cached.motion.reset(newPosition);
             }
 
-            cached.lastPosition = newPosition;
+            cached.velocity = cached.motion.velocity;
+            windowsMoving |= cached.velocity.lengthSquared() > WINDOW_MOVING_SPEED * WINDOW_MOVING_SPEED;
 
             newInGameWindowsData.push_back(cached);
         }
@@ -313,15 +638,34 @@ void CharactersManager::occludeInGameWindows()
 
 void CharactersManager::update(float deltaTime)
 {
-    // Collect windows data
-    collectWindowsData(deltaTime);
-    occludeInGameWindows();
+    // Windows and obstacles built from them, polled less often on lower quality levels
+    // World built during previous step becomes visible now
+    takeBuiltWorld();
+    const std::shared_ptr<const WorldSnapshot> world = getWorld();
+    navigation.update(*world);
+
+    windowsPollTime += deltaTime;
+    const bool polled = windowsPollStep == 0;
+    if (polled)
+    {
+        collectWindowsData(windowsPollTime);
+        windowsPollTime = 0.0f;
+    }
+    windowsPollStep = (windowsPollStep + 1) % getWindowsPollInterval();
 
-    // Update obstacles
-    updateObstacles();
+    // Between polls moving windows are extrapolated, static ones need no rebuild
+    if (polled || windowsMoving)
+    {
+        // World built now is used from next step on, so rects are predicted one step ahead
+        extrapolateWindows(windowsPollTime + deltaTime);
+        occludeInGameWindows();
+
+        // Obstacles are rebuilt while this step runs on the pinned snapshot
+        requestWorldBuild();
+    }
 
     // Update dragging
-    updateDragging(deltaTime);
+    updateDragging();
 
     // Update characters
     {
@@ -334,47 +678,109 @@ void CharactersManager::update(float deltaTime)
         target.exist = true;
         target.position = mouseWorldPosition;
 
-        PROFILE_SCOPE("Update characters");
-        for (auto& character : characters)
+        // Only characters due at this step are updated, each with time since its own last update
+        characterLOD.schedule(characters, *world, mouseWorldPosition, deltaTime);
+        const std::vector<uint32_t>& due = characterLOD.getDue();
+
+        // Route to the platform under the mouse is found once, followers only look up their next edge
+        navigation.setTarget(mouseWorldPosition);
+
+        Profiler::ProfileData collisionIterations;
+        Profiler::ProfileData collisionCarriedTime;
         {
-            character->setFollowTarget(target);
-            character->update(deltaTime);
+            PROFILE_SCOPE_NO_ALLOC("Update characters");
+            for (size_t i = 0; i < due.size(); i++)
+            {
+                Character& character = *characters[due[i]];
+                const BehaviourGoal& goal = behaviours.getGoal(due[i]);
+
+                Character::FollowTarget characterTarget;
+                if (goal.type == BehaviourGoal::Type::FollowMouse)
+                {
+                    characterTarget = target;
+                    NavigationGraph::Waypoint waypoint;
+                    if (navigation.getWaypoint(character, waypoint))
+                    {
+                        characterTarget.position = waypoint.position;
+                        characterTarget.jump = waypoint.jump;
+                        characterTarget.jumpVelocity = waypoint.jumpVelocity;
+                    }
+                }
+                else if (goal.type == BehaviourGoal::Type::MoveTo)
+                {
+                    characterTarget.exist = true;
+                    characterTarget.position = Vec2(goal.x, character.getPosition().y);
+                    characterTarget.jump = goal.jump;
+                    characterTarget.jumpVelocity = goal.jumpVelocity;
+                }
+
+                character.setFollowTarget(characterTarget);
+                character.update(characterLOD.getDueTime(i), *world);
+                collisionIterations.addSample(character.getCollisionIterations());
+                collisionCarriedTime.addSample(character.getCarriedTime());
+
+                behaviours.checkEvents(due[i], character);
+            }
         }
+        Profiler::addCounterSamples("Collision iterations", collisionIterations);
+        Profiler::addCounterSamples("Collision carried time", collisionCarriedTime);
+    }
+
+    // Character versus character
+    if (characterCollisionsEnabled)
+    {
+        characterCollisions.resolve(characters, *world);
+    }
+
+    characterPicking.update(characters);
+
+    // Behaviours, only those whose event or timer is due run
+    {
+        PROFILE_SCOPE("Run behaviours");
+        behaviours.update(characters, navigation);
+    }
+
+    // Crowd
+    if (crowd)
+    {
+        PROFILE_SCOPE("Update crowd");
+        crowd->update(deltaTime, *world);
     }
 }
 
-void CharactersManager::updateObstacles()
+// Runs on the world builder thread, so it only touches its arguments
+std::shared_ptr<const WorldSnapshot> CharactersManager::buildWorld(const std::vector<WorldWindow>& windows, Vec2 worldSize, uint64_t version)
 {
     PROFILE_FUNCTION();
 
-    auto& obstacles = Character::obstacles;
-    obstacles.clear();
+    auto snapshot = std::make_shared<WorldSnapshot>();
+    snapshot->version = version;
+    snapshot->size = worldSize;
+
+    auto& obstacles = snapshot->obstacles;
 
     // World
     {
         // Top
-        obstacles.emplace_back(Obstacle::Type::Horizontal, Character::worldSize.y, -Character::worldSize.x, Character::worldSize.x);
+        obstacles.emplace_back(Obstacle::Type::Horizontal, worldSize.y, -worldSize.x, worldSize.x);
 
         // Bottom
-        obstacles.emplace_back(Obstacle::Type::Horizontal, -Character::worldSize.y, -Character::worldSize.x, Character::worldSize.x);
+        obstacles.emplace_back(Obstacle::Type::Horizontal, -worldSize.y, -worldSize.x, worldSize.x);
 
         // Left
-        obstacles.emplace_back(Obstacle::Type::Vertical, -Character::worldSize.x, -Character::worldSize.y, Character::worldSize.y);
+        obstacles.emplace_back(Obstacle::Type::Vertical, -worldSize.x, -worldSize.y, worldSize.y);
 
         // Right
-        obstacles.emplace_back(Obstacle::Type::Vertical, Character::worldSize.x, -Character::worldSize.y, Character::worldSize.y);
+        obstacles.emplace_back(Obstacle::Type::Vertical, worldSize.x, -worldSize.y, worldSize.y);
     }
 
     // Windows
-    std::vector<AABB> occluders;
-    occluders.reserve(inGameWindowsData.size());
-    for (const auto& window : inGameWindowsData)
+    // Windows above the current one, eight per chunk
+    std::vector<AABBx8> occluders;
+    occluders.reserve(windows.size() / AABBx8::LANES + 1);
+    int occluderLane = AABBx8::LANES;
+    for (const auto& window : windows)
     {
-        if (window.occluded)
-        {
-            continue;
-        }
-
         const AABB& windowAABB = window.aabb;
 
         // Create obstacles
@@ -383,16 +789,23 @@ void CharactersManager::updateObstacles()
         Obstacle left(Obstacle::Type::Vertical, windowAABB.minX, windowAABB.minY, windowAABB.maxY);
         Obstacle right(Obstacle::Type::Vertical, windowAABB.maxX, windowAABB.minY, windowAABB.maxY);
 
-        top.velocity = window.velocity;
-        bottom.velocity = window.velocity;
-        left.velocity = window.velocity;
-        right.velocity = window.velocity;
+        top.setVelocity(window.velocity);
+        bottom.setVelocity(window.velocity);
+        left.setVelocity(window.velocity);
+        right.setVelocity(window.velocity);
 
         // Split
-        for (const auto& occluder : occluders)
+        for (const auto& chunk : occluders)
         {
-            if (occluder.isIntersecting(windowAABB))
+            unsigned mask = chunk.intersectingMask(windowAABB);
+            for (int lane = 0; mask != 0; lane++, mask >>= 1)
             {
+                if ((mask & 1) == 0)
+                {
+                    continue;
+                }
+
+                const AABB occluder = chunk.get(lane);
                 splitObstacleByAABB(top, occluder);
                 splitObstacleByAABB(bottom, occluder);
                 splitObstacleByAABB(left, occluder);
@@ -401,56 +814,148 @@ void CharactersManager::updateObstacles()
         }
 
         // Add segments
-        if (!top.segments.empty()) obstacles.push_back(std::move(top));
+        if (!top.segments.empty())
+        {
+            snapshot->windowTops.push_back(top); // Tells window tops from bottoms once lines are coalesced
+            obstacles.push_back(std::move(top));
+        }
         if (!bottom.segments.empty()) obstacles.push_back(std::move(bottom));
         if (!left.segments.empty()) obstacles.push_back(std::move(left));
         if (!right.segments.empty()) obstacles.push_back(std::move(right));
 
         // Add occluder
-        occluders.emplace_back(windowAABB);
+        if (occluderLane == AABBx8::LANES)
+        {
+            occluders.emplace_back();
+            occluderLane = 0;
+        }
+        occluders.back().set(occluderLane++, windowAABB);
     }
+
+    // Tiled and docked windows share edge lines, one obstacle per line is enough
+    Obstacle::coalesce(obstacles, OBSTACLE_COALESCE_EPSILON);
+    Obstacle::coalesce(snapshot->windowTops, OBSTACLE_COALESCE_EPSILON);
+
+    snapshot->finalize();
+    return snapshot;
 }
 
-void CharactersManager::updateDragging(float deltaTime)
+// Hands visible windows to the builder thread, which is idle since the previous rebuild was taken
+void CharactersManager::requestWorldBuild()
 {
-    if (draggedCharacter == nullptr)
+    if (!worldBuilder.joinable())
     {
-        return;
+        worldBuilder = std::thread(&CharactersManager::worldBuilderLoop, this);
     }
 
-    if (platformInterface->getMouseButtonPressed(MouseButton::Left))
     {
-        int mouseX, mouseY;
-        platformInterface->getGlobalMousePosition(mouseX, mouseY);
-        Vec2 mousePosition = screenToWorld({ mouseX, mouseY });
-
-        dragHistory.push_back({ mousePosition, deltaTime });
-        float totalTime = 0.0f;
-        for (int i = (int)dragHistory.size() - 1; i >= 0; --i)
+        std::lock_guard<std::mutex> lock(worldBuildMutex);
+        worldBuildWindows.clear();
+        for (const InGameWindowData& window : inGameWindowsData)
         {
-            totalTime += dragHistory[i].time;
-            if (totalTime > dragHistoryDuration)
+            if (!window.occluded)
             {
-                dragHistory.erase(dragHistory.begin(), dragHistory.begin() + i);
-                break;
+                worldBuildWindows.push_back({ window.aabb, window.velocity });
             }
         }
+        worldBuildVersion = ++worldVersion;
+        worldBuildRequested = true;
+    }
+    worldBuildPending = true;
+    worldBuildStarted.notify_one();
+}
 
-        draggedCharacter->setPosition(mousePosition + dragOffset);
+// Waits for the requested rebuild, if any, and publishes it
+void CharactersManager::takeBuiltWorld()
+{
+    if (!worldBuildPending)
+    {
+        return;
     }
-    else
+
+    std::shared_ptr<const WorldSnapshot> snapshot;
     {
-        if (!dragHistory.empty())
-        {
-            Vec2 deltaPos = dragHistory.back().position - dragHistory.front().position;
-            float totalTime = 0.0f;
-            for (auto& s : dragHistory) totalTime += s.time;
+        std::unique_lock<std::mutex> lock(worldBuildMutex);
+        worldBuildFinished.wait(lock, [this]() { return builtWorld != nullptr; });
+        snapshot = std::move(builtWorld);
+        builtWorld = nullptr;
+    }
+    worldBuildPending = false;
 
-            if (totalTime > 0.0f)
-            {
-                draggedCharacter->setVelocity(deltaPos / totalTime);
-            }
+    publishWorld(std::move(snapshot));
+}
+
+void CharactersManager::worldBuilderLoop()
+{
+    std::unique_lock<std::mutex> lock(worldBuildMutex);
+    while (true)
+    {
+        worldBuildStarted.wait(lock, [this]() { return worldBuilderExit || worldBuildRequested; });
+        if (worldBuilderExit)
+        {
+            return;
         }
+        worldBuildRequested = false;
+        const uint64_t version = worldBuildVersion;
+
+        // Input isn't touched by simulation until the result is taken, worldSize is set before this thread starts
+        lock.unlock();
+        std::shared_ptr<const WorldSnapshot> snapshot = buildWorld(worldBuildWindows, worldSize, version);
+        lock.lock();
+
+        builtWorld = std::move(snapshot);
+        worldBuildFinished.notify_one();
+    }
+}
+
+void CharactersManager::stopWorldBuilder()
+{
+    if (!worldBuilder.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(worldBuildMutex);
+        worldBuilderExit = true;
+    }
+    worldBuildStarted.notify_one();
+    worldBuilder.join();
+}
+
+// Swapping the pointer is the only thing done under the lock
+void CharactersManager::publishWorld(std::shared_ptr<const WorldSnapshot> snapshot)
+{
+    std::lock_guard<std::mutex> lock(worldMutex);
+    worldSnapshot.swap(snapshot);
+}
+
+std::shared_ptr<const WorldSnapshot> CharactersManager::getWorld() const
+{
+    std::lock_guard<std::mutex> lock(worldMutex);
+    return worldSnapshot;
+}
+
+void CharactersManager::updateDragging()
+{
+    if (draggedCharacter == nullptr)
+    {
+        return;
+    }
+
+    int mouseX, mouseY;
+    platformInterface->getGlobalMousePosition(mouseX, mouseY);
+    Vec2 mousePosition = screenToWorld({ mouseX, mouseY });
+
+    if (platformInterface->getMouseButtonPressed(MouseButton::Left))
+    {
+        draggedCharacter->setPosition(mousePosition + dragOffset);
+    }
+    else
+    {
+        // Release point closes the history, so a cursor held still before release gives no throw
+        addDragSample(mousePosition, platformInterface->getTimeSeconds());
+        draggedCharacter->setVelocity(estimateDragVelocity());
         dragHistory.clear();
 
         draggedCharacter->isBeingDragged = false;
@@ -458,6 +963,71 @@ void CharactersManager::updateDragging(float deltaTime)
     }
 }
 
+void CharactersManager::addDragSample(const Vec2& position, double time)
+{
+    dragHistory.push({ position, time });
+
+    // Drop samples that no longer affect velocity
+    size_t expired = 0;
+    while (expired < dragHistory.size() && time - dragHistory[expired].time > dragHistoryDuration)
+    {
+        expired++;
+    }
+    dragHistory.popFront(expired);
+}
+
+Vec2 CharactersManager::estimateDragVelocity() const
+{
+    if (dragHistory.size() < 2)
+    {
+        return Vec2();
+    }
+
+    // Weighted least squares line fit of position over time, slope is velocity
+    // Recent samples weigh up to twice as much as the oldest ones
+    // Times are taken relative to newest sample to keep precision
+    const double newestTime = dragHistory.back().time;
+    auto weight = [&](double t) { return 2.0 + t / dragHistoryDuration; };
+
+    double sumW = 0.0, sumT = 0.0, sumX = 0.0, sumY = 0.0;
+    for (size_t i = 0; i < dragHistory.size(); i++)
+    {
+        const DragSample& sample = dragHistory[i];
+        double t = sample.time - newestTime;
+        double w = weight(t);
+
+        sumW += w;
+        sumT += w * t;
+        sumX += w * sample.position.x;
+        sumY += w * sample.position.y;
+    }
+
+    const double meanT = sumT / sumW;
+    const double meanX = sumX / sumW;
+    const double meanY = sumY / sumW;
+
+    double sumTT = 0.0, sumTX = 0.0, sumTY = 0.0;
+    for (size_t i = 0; i < dragHistory.size(); i++)
+    {
+        const DragSample& sample = dragHistory[i];
+        double t = sample.time - newestTime;
+        double w = weight(t);
+
+        double dt = t - meanT;
+        sumTT += w * dt * dt;
+        sumTX += w * dt * (sample.position.x - meanX);
+        sumTY += w * dt * (sample.position.y - meanY);
+    }
+
+    // All samples at the same moment
+    if (sumTT < 1e-12)
+    {
+        return Vec2();
+    }
+
+    return Vec2((float)(sumTX / sumTT), (float)(sumTY / sumTT));
+}
+
 
 
 // Check for exit key combination (Ctrl + Shift + Q)
@@ -468,121 +1038,525 @@ bool CharactersManager::checkExitKeys()
         (GetAsyncKeyState('Q') & 0x8000);
 }
 
+// Handles everything window pushed since last poll, in order
+void CharactersManager::pollWindowEvents()
+{
+    size_t batch = 0;
+    WindowEvent evt;
+    while (windowEvents.pop(evt))
+    {
+        batch++;
+
+        InputEvent inputEvent;
+        const bool mouseEvent = toInputEvent(evt, inputEvent);
+
+        // While replaying, mouse comes from the capture only
+        if (mouseEvent && replay != nullptr)
+        {
+            continue;
+        }
+        if (mouseEvent && recorder != nullptr)
+        {
+            recorder->recordEvent(inputEvent);
+        }
+
+        onWindowEvent(evt);
+    }
+
+    windowEventsCount += batch;
+    largestWindowEventsBatch = std::max(largestWindowEventsBatch, batch);
+}
+
 void CharactersManager::onWindowEvent(const WindowEvent& evt)
 {
     if (evt.type == WindowEvent::Type::LeftMouseDown)
     {
         Vec2 mousePos = screenToWorld({ evt.localMouseX, evt.localMouseY });
-        interactLeftMouse(mousePos);
+        interactLeftMouse(mousePos, evt.timestamp);
+    }
+    else if (evt.type == WindowEvent::Type::MouseMove && draggedCharacter != nullptr)
+    {
+        Vec2 mousePos = screenToWorld({ evt.localMouseX, evt.localMouseY });
+        addDragSample(mousePos, evt.timestamp);
+    }
+}
+
+void CharactersManager::interactLeftMouse(const Vec2& mousePos, double time)
+{
+    // Top-most character under the mouse
+    characterPicking.queryPoint(mousePos, pickedCharacters);
+    if (pickedCharacters.empty())
+    {
+        return;
     }
+
+    Character* character = characters[pickedCharacters.front()].get();
+    character->isBeingDragged = true;
+    const Vec2& position = character->getPosition();
+
+    draggedCharacter = character;
+    dragOffset = position - mousePos;
+
+    dragHistory.clear();
+    addDragSample(mousePos, time);
 }
 
-void CharactersManager::interactLeftMouse(const Vec2& mousePos)
+
+// Replaces characters, windows and crowd with saved ones, false if there is no usable save
+bool CharactersManager::restoreState()
 {
-    for (const auto& character : characters)
+    PROFILE_FUNCTION();
+
+    // Replays start from a fresh simulation, a save of some later session would change every step
+    if (replay != nullptr)
     {
-        if (!character->getAABB().isContaining(mousePos))
+        return false;
+    }
+
+    SimulationState state;
+    if (!state.load(STATE_PATH))
+    {
+        return false;
+    }
+
+    // Screen resolution may have changed since, positions and velocities are kept relative to world size
+    const Vec2 scale(state.worldSize.x > 0.0f ? worldSize.x / state.worldSize.x : 1.0f,
+        state.worldSize.y > 0.0f ? worldSize.y / state.worldSize.y : 1.0f);
+
+    characters.clear();
+    characters.reserve(state.characters.size());
+    for (const SimulationState::CharacterState& saved : state.characters)
+    {
+        const Character::Data& data = state.characterTypes[saved.type];
+        navigation.fitCharacter(saved.size, data, CharacterLOD::getLongestStepTime(UPDATE_PERIOD));
+
+        auto character = std::make_unique<Character>(saved.position * scale, saved.size, data);
+        character->setVelocity(saved.velocity * scale);
+        character->setAnimation(saved.animationState, saved.animationTime, saved.facingLeft);
+        character->updateAABB();
+        characters.push_back(std::move(character));
+    }
+
+    // Scripts restart, coroutine frames aren't saved
+    behaviours.clear();
+    for (size_t i = 0; i < characters.size(); i++)
+    {
+        behaviours.start((uint32_t)i);
+    }
+
+    // Released drag is thrown with no velocity, history of previous run means nothing now
+    draggedCharacter = nullptr;
+    dragHistory.clear();
+    if (state.draggedCharacter >= 0)
+    {
+        draggedCharacter = characters[state.draggedCharacter].get();
+        draggedCharacter->isBeingDragged = true;
+        dragOffset = state.dragOffset * scale;
+    }
+
+    // Rects are refreshed by first poll, filters continue from saved motion
+    inGameWindowsData.clear();
+    for (const SimulationState::WindowState& saved : state.windows)
+    {
+        InGameWindowData cached;
+        cached.data.id = (size_t)saved.id;
+        cached.data.x = saved.x;
+        cached.data.y = saved.y;
+        cached.data.w = saved.w;
+        cached.data.h = saved.h;
+        cached.data.zOrder = saved.zOrder;
+        cached.motion.position = saved.filterPosition;
+        cached.motion.velocity = saved.filterVelocity;
+        cached.velocity = saved.filterVelocity;
+        inGameWindowsData.push_back(cached);
+    }
+
+    if (state.crowdEnabled)
+    {
+        enableCrowd(state.crowdData);
+        for (size_t i = 0; i < state.crowdPositions.size(); i++)
         {
-            continue;
+            crowd->addBody(state.crowdPositions[i] * scale, state.crowdVelocities[i] * scale);
         }
+    }
+
+    if (!Random::SetState(state.randomState))
+    {
+        std::cout << "Saved random state is invalid, keeping current one" << std::endl;
+    }
 
-        character->isBeingDragged = true;
-        const Vec2& position = character->getPosition();
+    std::cout << "Restored " << characters.size() << " characters from " << STATE_PATH << std::endl;
+    return true;
+}
 
-        draggedCharacter = character.get();
-        dragOffset = position - mousePos;
+// Plain copy between steps, vectors keep their capacity between saves
+void CharactersManager::captureState(SimulationState& state) const
+{
+    PROFILE_FUNCTION();
 
-        dragHistory.clear();
-        dragHistory.push_back({ position, 0.0f });
+    state.worldSize = worldSize;
 
-        break;
+    state.characterTypes.clear();
+    state.characters.resize(characters.size());
+    state.draggedCharacter = -1;
+    for (size_t i = 0; i < characters.size(); i++)
+    {
+        const Character& character = *characters[i];
+        SimulationState::CharacterState& saved = state.characters[i];
+
+        saved.position = character.getPosition();
+        saved.velocity = character.getVelocity();
+        saved.size = character.getSize();
+        saved.type = state.getCharacterType(character.getData());
+        saved.animationTime = character.getAnimationTime();
+        saved.animationState = character.getAnimationState();
+        saved.facingLeft = character.isFacingLeft();
+
+        if (&character == draggedCharacter)
+        {
+            state.draggedCharacter = (int32_t)i;
+        }
+    }
+    state.dragOffset = dragOffset;
+
+    state.windows.resize(inGameWindowsData.size());
+    for (size_t i = 0; i < inGameWindowsData.size(); i++)
+    {
+        const InGameWindowData& window = inGameWindowsData[i];
+        SimulationState::WindowState& saved = state.windows[i];
+
+        saved.id = window.data.id;
+        saved.x = window.data.x;
+        saved.y = window.data.y;
+        saved.w = window.data.w;
+        saved.h = window.data.h;
+        saved.zOrder = window.data.zOrder;
+        saved.filterPosition = window.motion.position;
+        saved.filterVelocity = window.motion.velocity;
+    }
+
+    state.crowdEnabled = crowd != nullptr;
+    state.crowdPositions.clear();
+    state.crowdVelocities.clear();
+    if (crowd)
+    {
+        state.crowdData = crowd->getData();
+        for (size_t i = 0; i < crowd->getCount(); i++)
+        {
+            state.crowdPositions.push_back(crowd->getPosition(i));
+            state.crowdVelocities.push_back(crowd->getVelocity(i));
+        }
+    }
+
+    state.randomState = Random::GetState();
+}
+
+// Captures state now and writes it on another thread
+// Skipped while previous save is still writing, unless waiting is asked for
+void CharactersManager::saveState(bool wait)
+{
+    // Replayed sessions don't overwrite the save of real ones
+    if (replay != nullptr)
+    {
+        return;
+    }
+
+    if (pendingSave.valid())
+    {
+        if (!wait && pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
+        pendingSave.get();
+    }
+
+    if (!savedState)
+    {
+        savedState = std::make_shared<SimulationState>();
+    }
+    captureState(*savedState);
+
+    std::shared_ptr<const SimulationState> state = savedState;
+    pendingSave = std::async(std::launch::async, [state]() { return state->save(STATE_PATH); });
+
+    if (wait)
+    {
+        pendingSave.get();
     }
 }
 
+void CharactersManager::exportMetrics()
+{
+    if (!metrics.isOpen())
+    {
+        return;
+    }
+
+    PROFILE_FUNCTION();
+
+    using Type = MetricsExporter::Type;
+
+    const double quantiles[] = { 0.5, 0.9, 0.99 };
+    for (double quantile : quantiles)
+    {
+        std::ostringstream label;
+        label << "quantile=\"" << quantile << "\"";
+        metrics.set("desktopcharacters_frame_time_ms", Profiler::getFrameTimePercentile(quantile), Type::Gauge, label.str());
+    }
+
+    metrics.set("desktopcharacters_frames_total", (double)framesCount, Type::Counter);
+    metrics.set("desktopcharacters_steps_total", (double)stepsCount, Type::Counter);
+
+    metrics.set("desktopcharacters_windows", (double)windowsData.size());
+    metrics.set("desktopcharacters_ingame_windows", (double)inGameWindowsData.size());
+
+    const std::shared_ptr<const WorldSnapshot> world = getWorld();
+
+    size_t segmentsCount = 0;
+    for (const auto& obstacle : world->obstacles)
+    {
+        segmentsCount += obstacle.segments.size();
+    }
+    metrics.set("desktopcharacters_world_version", (double)world->version, Type::Counter);
+    metrics.set("desktopcharacters_obstacles", (double)world->obstacles.size());
+    metrics.set("desktopcharacters_obstacle_segments", (double)segmentsCount);
+
+#ifdef PROFILE_ALLOCATIONS
+    metrics.set("desktopcharacters_allocation_violations_total", (double)Profiler::getAllocationViolationsCount(), Type::Counter);
+#endif
+
+    metrics.set("desktopcharacters_navigation_platforms", (double)navigation.getPlatforms().size());
+    metrics.set("desktopcharacters_navigation_edges", (double)navigation.getEdgesCount());
+    metrics.set("desktopcharacters_navigation_rebuilt_platforms_total", (double)navigation.getRebuiltPlatformsCount(), Type::Counter);
+
+    metrics.set("desktopcharacters_quality_level", (double)qualityGovernor.getLevel());
+    metrics.set("desktopcharacters_quality_transitions_total", (double)qualityGovernor.getTransitionsCount(), Type::Counter);
+
+    metrics.set("desktopcharacters_behaviour_resumes_total", (double)behaviours.getResumedCount(), Type::Counter);
+
+    metrics.set("desktopcharacters_window_events_total", (double)windowEventsCount, Type::Counter);
+    metrics.set("desktopcharacters_window_events_dropped_total", (double)windowEvents.getDroppedCount(), Type::Counter);
+    metrics.set("desktopcharacters_window_events_largest_batch", (double)largestWindowEventsBatch);
+    largestWindowEventsBatch = 0;
+
+    metrics.set("desktopcharacters_characters", (double)characters.size());
+    metrics.set("desktopcharacters_characters_lod", (double)characterLOD.getTierCount(CharacterLOD::Tier::High), Type::Gauge, "tier=\"high\"");
+    metrics.set("desktopcharacters_characters_lod", (double)characterLOD.getTierCount(CharacterLOD::Tier::Medium), Type::Gauge, "tier=\"medium\"");
+    metrics.set("desktopcharacters_characters_lod", (double)characterLOD.getTierCount(CharacterLOD::Tier::Low), Type::Gauge, "tier=\"low\"");
+    metrics.set("desktopcharacters_crowd_bodies", crowd ? (double)crowd->getCount() : 0.0);
+
+    if (recorder != nullptr)
+    {
+        metrics.set("desktopcharacters_capture_bytes_total", (double)recorder->getWriter().getBytesWritten(), Type::Counter);
+        metrics.set("desktopcharacters_capture_dropped_chunks_total", (double)recorder->getWriter().getDroppedChunksCount(), Type::Counter);
+    }
+
+    metrics.write();
+}
+
+void CharactersManager::onQualityLevelChanged()
+{
+    QualityGovernor::Level level = qualityGovernor.getLevel();
+
+    bool reducedPhysics = qualityGovernor.isAtLeast(QualityGovernor::Level::ReducedDistantPhysics);
+    characterLOD.setDistanceScale(reducedPhysics ? 0.5f : 1.0f);
+
+    std::cout << "Quality level: " << QualityGovernor::getLevelName(level)
+        << " (frame time p90 " << qualityGovernor.getLastPercentile() << " ms)" << std::endl;
+
+    // Transitions are rare, so they are written out right away instead of waiting for next export
+    exportMetrics();
+}
+
+int CharactersManager::getWindowsPollInterval() const
+{
+    // In steps of 60 Hz simulation, window motion is extrapolated in between
+    if (qualityGovernor.isAtLeast(QualityGovernor::Level::MinimalWindowPolling))
+    {
+        return 12;
+    }
+    if (qualityGovernor.isAtLeast(QualityGovernor::Level::ReducedWindowPolling))
+    {
+        return 6;
+    }
+    return 4;
+}
 
-void CharactersManager::render()
+// Copies everything render thread needs into the next snapshot
+void CharactersManager::publishSnapshot()
 {
+    FrameSnapshot& frame = frameSnapshots.getWriteBuffer();
+
+    frame.worldToScreen = worldToScreenTransform;
+
     // Characters
-    for (const auto& character : characters)
+    frame.characters.resize(characters.size());
+    for (size_t i = 0; i < characters.size(); i++)
+    {
+        const Character& character = *characters[i];
+
+        FrameSnapshot::CharacterState& state = frame.characters[i];
+        state.aabb = character.getAABB();
+        state.animationState = character.getAnimationState();
+        state.animationTime = character.getAnimationTime();
+        state.facingLeft = character.isFacingLeft();
+    }
+
+    // Crowd
+    frame.crowdBodies.clear();
+    if (crowd)
     {
-        const AABB& aabb = character->getAABB();
+        const Vec2 halfSize = crowd->getData().bodySize * 0.5f;
+
+        frame.crowdBodies.resize(crowd->getCount());
+        for (size_t i = 0; i < crowd->getCount(); i++)
+        {
+            const Vec2 position = crowd->getPosition(i);
+            frame.crowdBodies[i] = AABB(position - halfSize, position + halfSize);
+        }
+    }
 
-        Vec2 topLeft = worldToScreen({ aabb.minX, aabb.maxY });
-        Vec2 bottomRight = worldToScreen({ aabb.maxX, aabb.minY });
+    // Obstacles are drawn from the world snapshot itself, nothing is copied
+    // Overlay is the first thing given up when frames are over budget
+    frame.world = getWorld();
+    frame.drawObstacles = !qualityGovernor.isAtLeast(QualityGovernor::Level::NoObstacleOverlay);
 
-        Vec2 rectSize = bottomRight - topLeft;
+    frameSnapshots.publish();
+    publishedSnapshotsCount++;
+    publishedSnapshotsCount.notify_one();
+}
 
-        Color color = { 1.0f, 0.0f, 0.0f, 1.0f };
+// Runs on render thread
+void CharactersManager::render(const FrameSnapshot& frame)
+{
+    BaseRenderer* renderer = mainWindow->getRenderer();
 
-        mainWindow->getRenderer()->drawRectangle(topLeft, rectSize, color);
+    // Characters
+    screenRects.resize(frame.characters.size());
+    for (size_t i = 0; i < frame.characters.size(); i++)
+    {
+        screenRects[i] = frame.characters[i].aabb;
     }
+    frame.worldToScreen.apply(screenRects.data(), screenRects.data(), screenRects.size());
 
-    // Obstacles
-    for (const auto& obst : Character::obstacles)
+    if (renderer->hasSpriteAtlas())
     {
-        for (const auto& segment : obst.segments)
+        renderCharacterSprites(frame);
+    }
+    else
+    {
+        for (const AABB& rect : screenRects)
         {
-            Vec2 p1, p2;
+            Color color = { 1.0f, 0.0f, 0.0f, 1.0f };
 
-            if (obst.type == Obstacle::Type::Horizontal)
-            {
-                float obst_min = map(segment.min, -Character::worldSize.x, Character::worldSize.x, 0.0f, screenSize.x);
-                float obst_max = map(segment.max, -Character::worldSize.x, Character::worldSize.x, 0.0f, screenSize.x);
-                float obst_perp = map(-obst.perpOffset, -Character::worldSize.y, Character::worldSize.y, 0.0f, screenSize.y);
+            renderer->drawRectangle(rect.minX, rect.minY, rect.maxX - rect.minX, rect.maxY - rect.minY, color);
+        }
+    }
 
-                p1.x = obst_min;
-                p1.y = obst_perp;
+    // Crowd
+    if (!frame.crowdBodies.empty())
+    {
+        PROFILE_SCOPE("Render thread: crowd");
 
-                p2.x = obst_max;
-                p2.y = obst_perp;
-            }
-            else
-            {
-                float obst_min = map(-segment.min, -Character::worldSize.y, Character::worldSize.y, 0.0f, screenSize.y);
-                float obst_max = map(-segment.max, -Character::worldSize.y, Character::worldSize.y, 0.0f, screenSize.y);
-                float obst_perp = map(obst.perpOffset, -Character::worldSize.x, Character::worldSize.x, 0.0f, screenSize.x);
+        const Color color = { 1.0f, 0.5f, 0.0f, 1.0f };
 
-                p1.x = obst_perp;
-                p1.y = obst_min;
+        screenRects.resize(frame.crowdBodies.size());
+        frame.worldToScreen.apply(frame.crowdBodies.data(), screenRects.data(), screenRects.size());
 
-                p2.x = obst_perp;
-                p2.y = obst_max;
+        for (const AABB& rect : screenRects)
+        {
+            renderer->drawRectangle(rect.minX, rect.minY, rect.maxX - rect.minX, rect.maxY - rect.minY, color);
+        }
+    }
+
+    // Obstacles
+    obstaclePoints.clear();
+    if (frame.drawObstacles && frame.world)
+    {
+        for (const auto& obst : frame.world->obstacles)
+        {
+            for (const auto& segment : obst.segments)
+            {
+                if (obst.type == Obstacle::Type::Horizontal)
+                {
+                    obstaclePoints.emplace_back(segment.min, obst.perpOffset);
+                    obstaclePoints.emplace_back(segment.max, obst.perpOffset);
+                }
+                else
+                {
+                    obstaclePoints.emplace_back(obst.perpOffset, segment.min);
+                    obstaclePoints.emplace_back(obst.perpOffset, segment.max);
+                }
             }
+        }
+    }
 
-            Color color = { 0.0f, 0.0f, 1.0f, 1.0f };
+    screenPoints.resize(obstaclePoints.size());
+    frame.worldToScreen.apply(obstaclePoints.data(), screenPoints.data(), screenPoints.size());
 
-            mainWindow->getRenderer()->drawLine(p1, p2, color, 5.0f);
-        }
+    for (size_t i = 0; i + 1 < screenPoints.size(); i += 2)
+    {
+        Color color = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+        renderer->drawLine(screenPoints[i], screenPoints[i + 1], color, 5.0f);
     }
 }
 
-
-float CharactersManager::map(float value, float min1, float max1, float min2, float max2) const
+// All characters are submitted as one sprite batch
+// Expects screenRects to hold characters' screen rectangles
+void CharactersManager::renderCharacterSprites(const FrameSnapshot& frame)
 {
-    float range = max1 - min1;
-    if (fabsf(range) < 1e-6f) // Avoid division by zero
-        return min2;
+    sprites.resize(frame.characters.size());
+
+    for (size_t i = 0; i < frame.characters.size(); i++)
+    {
+        const FrameSnapshot::CharacterState& character = frame.characters[i];
+        const AABB& rect = screenRects[i];
+
+        int animation = animationIndices[(int)character.animationState];
+        const SpriteAtlas::Frame& atlasFrame = spriteAtlas.getFrame(animation, character.animationTime);
+
+        Sprite& sprite = sprites[i];
+        sprite.x = rect.minX;
+        sprite.y = rect.minY;
+        sprite.w = rect.maxX - rect.minX;
+        sprite.h = rect.maxY - rect.minY;
+        sprite.srcX = atlasFrame.x;
+        sprite.srcY = atlasFrame.y;
+        sprite.srcW = atlasFrame.w;
+        sprite.srcH = atlasFrame.h;
+        sprite.flipX = character.facingLeft;
+    }
 
-    float normalized = (value - min1) / range;
-    return min2 + normalized * (max2 - min2);
+    mainWindow->getRenderer()->drawSprites(sprites);
 }
 
-Vec2 CharactersManager::map(const Vec2& value, const Vec2& min1, const Vec2& max1, const Vec2& min2, const Vec2& max2) const
+
+// Rebuilds cached transforms if screen or world size changed
+void CharactersManager::updateTransforms()
 {
-    Vec2 normalized = (value - min1) / (max1 - min1);
-    return min2 + normalized * (max2 - min2);
+    if (screenSize == transformsScreenSize && worldSize == transformsWorldSize)
+    {
+        return;
+    }
+
+    transformsScreenSize = screenSize;
+    transformsWorldSize = worldSize;
+
+    // Screen Y grows downwards, world Y grows upwards
+    worldToScreenTransform = AffineTransform::fromRanges(
+        Vec2(-worldSize.x, worldSize.y), Vec2(worldSize.x, -worldSize.y),
+        Vec2(0.0f, 0.0f), screenSize
+    );
+    screenToWorldTransform = worldToScreenTransform.inverse();
 }
 
 Vec2 CharactersManager::screenToWorld(const Vec2& screen) const
 {
-    Vec2 coord = map(screen, Vec2(), screenSize, -Character::worldSize, Character::worldSize);
-    coord.y = -coord.y;
-    return coord;
+    return screenToWorldTransform.apply(screen);
 }
 
 Vec2 CharactersManager::worldToScreen(const Vec2& world) const
 {
-    Vec2 coord = map(world, -Character::worldSize, Character::worldSize, Vec2(), screenSize);
-    coord.y = screenSize.y - coord.y;
-    return coord;
+    return worldToScreenTransform.apply(world);
 }
@@ -5,18 +5,53 @@ using WindowClass = Windows_Window;
 #include "PlatformInterface/Windows_PlatformInterface.h"
 using PlatformInterfaceClass = Windows_PlatformInterface;
 
-#include "Character.h"
+#include "PlatformInterface/Recording_PlatformInterface.h"
+#include "PlatformInterface/Replay_PlatformInterface.h"
 
-#include <vector>
+#include "Character.h"
+#include "CharacterBehaviours.h"
+#include "Core/AffineTransform.h"
+#include "CharacterCollisions.h"
+#include "CharacterLOD.h"
+#include "CharacterSpatialHash.h"
+#include "Crowd.h"
+#include "FrameSnapshot.h"
+#include "NavigationGraph.h"
+#include "QualityGovernor.h"
+#include "SimulationState.h"
+#include "WorldSnapshot.h"
+
+#include "Core/AlphaBetaFilter.h"
+#include "Core/MetricsExporter.h"
+#include "Core/RingBuffer.h"
+#include "Core/TripleBuffer.h"
+
+#include "Window/Renderer/SpriteAtlas.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// What the world builder needs of a visible window
+struct WorldWindow
+{
+    AABB aabb;
+    Vec2 velocity;
+};
 
 struct InGameWindowData
 {
     WindowData data;
     Vec2 velocity;
-    Vec2 lastPosition;
+    AlphaBetaFilter motion; // Tracks min corner between polls
 
-    AABB aabb;
+    AABB measuredAABB; // As of last poll
+
+    AABB aabb; // Extrapolated between polls
     bool occluded = false;
 };
 
@@ -26,27 +61,120 @@ public:
     CharactersManager();
     ~CharactersManager();
 
+    // Input capture and replay, set before initialize()
+    void setCapturePath(const std::string& path);
+    void setReplay(const std::string& path, double startSeconds, double speed, bool fixedStep);
+
     bool initialize();
 
+    // Resumes simulation saved by previous run, call before runLoop()
+    // Does nothing when replaying, replays neither read nor write saved state
+    bool restoreState();
+
     bool addCharacter(const Vec2& position, const Vec2& velocity, const Character::Data& charData);
 
+    void enableCrowd(const Crowd::Data& crowdData);
+    bool addCrowdBody(const Vec2& position, const Vec2& velocity);
+
     int runLoop();
+
+    void setCharacterCollisionsEnabled(bool enabled);
 private:
     // Core platform and window management
     std::unique_ptr<BasePlatformInterface> platformInterface;
+    WindowEventQueue windowEvents; // Outlives mainWindow, which pushes into it
     std::unique_ptr<BaseWindow> mainWindow;
     Vec2 screenSize;
 
+    // Input capture and replay, both wrap platform interface
+    std::string capturePath;
+    std::string replayPath;
+    double replayStartSeconds = 0.0;
+    double replaySpeed = 1.0;
+    bool replayFixedStep = false; // Replay clock is faked and moves exactly one step per loop
+    Recording_PlatformInterface* recorder = nullptr; // Owned by platformInterface
+    Replay_PlatformInterface* replay = nullptr;
+
+    // World
+    Vec2 worldSize; // Half extents, center is at zero
+    std::shared_ptr<const WorldSnapshot> worldSnapshot; // Only accessed through publishWorld() and getWorld()
+    mutable std::mutex worldMutex;
+    uint64_t worldVersion = 0;
+
+    // World builder thread, started on first rebuild and kept until exit
+    // Simulation hands it one rebuild per step and takes the result at the start of the next one
+    std::thread worldBuilder;
+    std::mutex worldBuildMutex;
+    std::condition_variable worldBuildStarted;
+    std::condition_variable worldBuildFinished;
+    std::vector<WorldWindow> worldBuildWindows; // Input of the requested rebuild, reused
+    uint64_t worldBuildVersion = 0;
+    bool worldBuildRequested = false;
+    bool worldBuildPending = false; // Requested and not taken yet, only used by simulation thread
+    bool worldBuilderExit = false;
+    std::shared_ptr<const WorldSnapshot> builtWorld;
+
+    // Screen <-> world, cached for current screenSize and worldSize
+    AffineTransform worldToScreenTransform;
+    AffineTransform screenToWorldTransform;
+    Vec2 transformsScreenSize;
+    Vec2 transformsWorldSize;
+
     // State
-    bool shouldExit;
+    std::atomic<bool> shouldExit;
 
     // Windows' data
     std::vector<WindowData> windowsData;
     std::vector<InGameWindowData> inGameWindowsData;
+    bool windowsMoving = false; // Any window had velocity at last poll
 
     // Characters
     std::vector<std::unique_ptr<Character>> characters;
-    
+    CharacterCollisions characterCollisions;
+    bool characterCollisionsEnabled = false;
+    CharacterSpatialHash characterPicking;
+    CharacterLOD characterLOD;
+    NavigationGraph navigation; // Shared by every follower
+    CharacterBehaviours behaviours; // Script of every character, by index
+    std::vector<uint32_t> pickedCharacters; // Query scratch
+
+    // Crowd mode
+    std::unique_ptr<Crowd> crowd;
+
+    // Rendering
+    std::thread renderThread;
+    TripleBuffer<FrameSnapshot> frameSnapshots;
+    std::atomic<uint64_t> publishedSnapshotsCount{ 0 }; // Render thread waits on it while there's nothing new
+
+    // Simulation thread waits on it between steps, high resolution where supported
+    HANDLE stepTimer = nullptr;
+    bool timerPeriodRaised = false; // timeBeginPeriod(1) in effect for older systems
+
+    // Sprites, owned by render thread
+    SpriteAtlas spriteAtlas;
+    int animationIndices[4] = { -1, -1, -1, -1 }; // Atlas animation for each Character::AnimationState
+    std::vector<Sprite> sprites;
+
+    // Render thread scratch, reused between frames
+    std::vector<AABB> screenRects;
+    std::vector<Vec2> screenPoints;
+    std::vector<Vec2> obstaclePoints; // Segment endpoints, two per segment
+
+    // Quality
+    QualityGovernor qualityGovernor;
+    int windowsPollStep = 0; // Steps since windows were polled, wraps at poll interval
+    float windowsPollTime = 0.0f; // Time since windows were polled
+
+    // Saved state, written periodically and on exit
+    std::shared_ptr<SimulationState> savedState; // Reused once its previous save finished
+    std::future<bool> pendingSave;
+
+    // Metrics
+    MetricsExporter metrics;
+    uint64_t framesCount = 0;
+    uint64_t stepsCount = 0;
+    uint64_t windowEventsCount = 0;
+    size_t largestWindowEventsBatch = 0; // Since last export
 
     // Dragging
     Character* draggedCharacter = nullptr;
@@ -54,28 +182,50 @@ private:
     struct DragSample
     {
         Vec2 position;
-        float time; // in seconds
+        double time; // WindowEvent timestamp, in seconds
     };
-    std::vector<DragSample> dragHistory;
-    const float dragHistoryDuration = 0.1f; // track last 0.1 seconds for velocity
+    RingBuffer<DragSample, 256> dragHistory; // Fed by mouse events, not by simulation steps
+    const double dragHistoryDuration = 0.1; // track last 0.1 seconds for velocity
 private:
     void collectWindowsData(float deltaTime);
+    void extrapolateWindows(float timeAhead);
     void occludeInGameWindows();
 
     void update(float deltaTime);
-    void updateObstacles();
-    void updateDragging(float deltaTime);
-
-    void render();
+    static std::shared_ptr<const WorldSnapshot> buildWorld(const std::vector<WorldWindow>& windows, Vec2 worldSize, uint64_t version);
+    void requestWorldBuild();
+    void takeBuiltWorld();
+    void worldBuilderLoop();
+    void stopWorldBuilder();
+    void publishWorld(std::shared_ptr<const WorldSnapshot> snapshot);
+    std::shared_ptr<const WorldSnapshot> getWorld() const;
+    void updateDragging();
+    void addDragSample(const Vec2& position, double time);
+    Vec2 estimateDragVelocity() const;
+
+    void loadSprites();
+
+    void captureState(SimulationState& state) const;
+    void saveState(bool wait);
+
+    void exportMetrics();
+    void onQualityLevelChanged();
+    int getWindowsPollInterval() const;
+
+    void publishSnapshot();
+    void renderLoop();
+    void waitForNextStep(float seconds);
+    void render(const FrameSnapshot& frame);
+    void renderCharacterSprites(const FrameSnapshot& frame);
 
     bool checkExitKeys();
 
+    void pollWindowEvents();
     void onWindowEvent(const WindowEvent& evt);
 
-    void interactLeftMouse(const Vec2& mousePos);
+    void interactLeftMouse(const Vec2& mousePos, double time);
 
-    float map(float value, float min1, float max1, float min2, float max2) const;
-    Vec2 map(const Vec2& value, const Vec2& min1, const Vec2& max1, const Vec2& min2, const Vec2& max2) const;
+    void updateTransforms();
     Vec2 screenToWorld(const Vec2& screen) const;
     Vec2 worldToScreen(const Vec2& world) const;
 };
\ No newline at end of file
@@ -1,16 +1,31 @@
 #pragma once
 #include "Vec2.h"
 
+#include <type_traits>
+
 struct AABB
 {
 	float minX, minY, maxX, maxY;
 
-	AABB();
-	AABB(float minX, float minY, float maxX, float maxY);
-	AABB(const Vec2& min, const Vec2& max);
+	constexpr AABB() : minX(0), minY(0), maxX(0), maxY(0) {}
+	constexpr AABB(float minX, float minY, float maxX, float maxY) : minX(minX), minY(minY), maxX(maxX), maxY(maxY) {}
+	constexpr AABB(const Vec2& min, const Vec2& max) : minX(min.x), minY(min.y), maxX(max.x), maxY(max.y) {}
+
+	constexpr bool isIntersecting(const AABB& other) const
+	{
+		return minX < other.maxX && maxX > other.minX && minY < other.maxY && maxY > other.minY;
+	}
+
+	constexpr bool isContaining(const Vec2& point) const
+	{
+		return minX <= point.x && point.x <= maxX && minY <= point.y && point.y <= maxY;
+	}
 
-	bool isIntersecting(const AABB& other) const;
-	bool isContaining(const Vec2& point) const;
-	bool isContaining(const AABB& inner) const;
+	constexpr bool isContaining(const AABB& inner) const
+	{
+		return inner.minX >= minX && inner.maxX <= maxX && inner.minY >= minY && inner.maxY <= maxY;
+	}
 };
 
+static_assert(std::is_trivially_copyable<AABB>::value, "AABB must stay trivially copyable");
+static_assert(sizeof(AABB) == 4 * sizeof(float), "AABB must be four packed floats");
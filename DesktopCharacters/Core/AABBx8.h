@@ -0,0 +1,67 @@
+#pragma once
+#include "AABB.h"
+#include "Vec2.h"
+
+#include <cfloat>
+#include <cstddef>
+
+// Eight AABBs stored as separate lanes per bound
+// Queries return a bit mask with one bit per lane
+struct alignas(32) AABBx8
+{
+    static constexpr int LANES = 8;
+
+    float minX[LANES];
+    float minY[LANES];
+    float maxX[LANES];
+    float maxY[LANES];
+
+    // Unused lanes are inverted boxes, which never intersect or contain anything
+    AABBx8()
+    {
+        for (int i = 0; i < LANES; i++)
+        {
+            minX[i] = FLT_MAX; minY[i] = FLT_MAX;
+            maxX[i] = -FLT_MAX; maxY[i] = -FLT_MAX;
+        }
+    }
+
+    static AABBx8 load(const AABB* boxes, size_t count)
+    {
+        AABBx8 result;
+        for (size_t i = 0; i < count && i < LANES; i++)
+        {
+            result.set((int)i, boxes[i]);
+        }
+        return result;
+    }
+
+    AABB get(int lane) const { return AABB(minX[lane], minY[lane], maxX[lane], maxY[lane]); }
+    void set(int lane, const AABB& box)
+    {
+        minX[lane] = box.minX; minY[lane] = box.minY;
+        maxX[lane] = box.maxX; maxY[lane] = box.maxY;
+    }
+
+    unsigned intersectingMask(const AABB& other) const
+    {
+        unsigned mask = 0;
+        for (int i = 0; i < LANES; i++)
+        {
+            bool hit = (minX[i] < other.maxX) & (maxX[i] > other.minX) & (minY[i] < other.maxY) & (maxY[i] > other.minY);
+            mask |= (unsigned)hit << i;
+        }
+        return mask;
+    }
+
+    unsigned containingMask(const Vec2& point) const
+    {
+        unsigned mask = 0;
+        for (int i = 0; i < LANES; i++)
+        {
+            bool hit = (minX[i] <= point.x) & (point.x <= maxX[i]) & (minY[i] <= point.y) & (point.y <= maxY[i]);
+            mask |= (unsigned)hit << i;
+        }
+        return mask;
+    }
+};
@@ -0,0 +1,92 @@
+#include "AffineTransform.h"
+
+#include <emmintrin.h>
+
+#include <cmath>
+
+static_assert(sizeof(Vec2) == 2 * sizeof(float), "Vec2 must be two packed floats");
+static_assert(sizeof(AABB) == 4 * sizeof(float), "AABB must be four packed floats");
+
+AffineTransform::AffineTransform() :
+	scale(1.0f, 1.0f), offset(0.0f, 0.0f)
+{
+}
+
+AffineTransform::AffineTransform(const Vec2& scale, const Vec2& offset) :
+	scale(scale), offset(offset)
+{
+}
+
+AffineTransform AffineTransform::fromRanges(const Vec2& from1, const Vec2& from2, const Vec2& to1, const Vec2& to2)
+{
+	Vec2 range = from2 - from1;
+
+	// Avoid division by zero
+	Vec2 newScale(
+		fabsf(range.x) < 1e-6f ? 0.0f : (to2.x - to1.x) / range.x,
+		fabsf(range.y) < 1e-6f ? 0.0f : (to2.y - to1.y) / range.y
+	);
+
+	return AffineTransform(newScale, to1 - from1 * newScale);
+}
+
+AffineTransform AffineTransform::inverse() const
+{
+	Vec2 inverseScale(
+		scale.x != 0.0f ? 1.0f / scale.x : 0.0f,
+		scale.y != 0.0f ? 1.0f / scale.y : 0.0f
+	);
+
+	return AffineTransform(inverseScale, -offset * inverseScale);
+}
+
+Vec2 AffineTransform::apply(const Vec2& point) const
+{
+	return point * scale + offset;
+}
+
+AABB AffineTransform::apply(const AABB& box) const
+{
+	Vec2 a = apply(Vec2(box.minX, box.minY));
+	Vec2 b = apply(Vec2(box.maxX, box.maxY));
+
+	return AABB(fminf(a.x, b.x), fminf(a.y, b.y), fmaxf(a.x, b.x), fmaxf(a.y, b.y));
+}
+
+void AffineTransform::apply(const Vec2* points, Vec2* result, size_t count) const
+{
+	const __m128 scale2 = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+	const __m128 offset2 = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+
+	// Two points per register
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128 p = _mm_loadu_ps(&points[i].x);
+		_mm_storeu_ps(&result[i].x, _mm_add_ps(_mm_mul_ps(p, scale2), offset2));
+	}
+
+	for (; i < count; i++)
+	{
+		result[i] = apply(points[i]);
+	}
+}
+
+void AffineTransform::apply(const AABB* boxes, AABB* result, size_t count) const
+{
+	const __m128 scale2 = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+	const __m128 offset2 = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		// (minX, minY, maxX, maxY)
+		__m128 box = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&boxes[i].minX), scale2), offset2);
+
+		// (maxX, maxY, minX, minY)
+		__m128 swapped = _mm_shuffle_ps(box, box, _MM_SHUFFLE(1, 0, 3, 2));
+
+		__m128 low = _mm_min_ps(box, swapped);
+		__m128 high = _mm_max_ps(box, swapped);
+		_mm_storeu_ps(&result[i].minX, _mm_movelh_ps(low, high));
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "AABB.h"
+#include "Vec2.h"
+
+#include <cstddef>
+
+// Per-axis scale followed by offset: result = point * scale + offset
+struct AffineTransform
+{
+	Vec2 scale;
+	Vec2 offset;
+
+	AffineTransform();
+	AffineTransform(const Vec2& scale, const Vec2& offset);
+
+	// Maps range [from1, from2] onto [to1, to2] on both axes
+	static AffineTransform fromRanges(const Vec2& from1, const Vec2& from2, const Vec2& to1, const Vec2& to2);
+
+	AffineTransform inverse() const;
+
+	Vec2 apply(const Vec2& point) const;
+	AABB apply(const AABB& box) const; // Min/max are re-sorted, so mirrored axes give valid boxes
+
+	// Batch versions, result may be the same array as input
+	void apply(const Vec2* points, Vec2* result, size_t count) const;
+	void apply(const AABB* boxes, AABB* result, size_t count) const;
+};
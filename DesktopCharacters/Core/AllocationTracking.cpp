@@ -0,0 +1,152 @@
+#include "Profiler.h"
+
+#ifdef PROFILE_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+// Replaces global allocation functions so every heap allocation
+// is attributed to innermost profiler zone of the allocating thread
+
+namespace
+{
+	void* allocate(size_t size)
+	{
+		Profiler::recordAllocation(size);
+		return std::malloc(size ? size : 1);
+	}
+
+	// Over-aligned types (alignas above 16) come through these, they need their own free function
+	void* allocateAligned(size_t size, std::align_val_t alignment)
+	{
+		Profiler::recordAllocation(size);
+		size = size ? size : 1;
+#ifdef _WIN32
+		return _aligned_malloc(size, (size_t)alignment);
+#else
+		// Size must be a multiple of alignment here
+		return std::aligned_alloc((size_t)alignment, (size + (size_t)alignment - 1) & ~((size_t)alignment - 1));
+#endif
+	}
+
+	void freeAligned(void* pointer)
+	{
+#ifdef _WIN32
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* pointer = allocate(size);
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* pointer = allocateAligned(size, alignment);
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(pointer);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include "Vec2.h"
+
+// Alpha-beta tracker for a point moving with roughly constant velocity
+// Smooths velocity from noisy or sparse position samples and predicts positions between them
+struct AlphaBetaFilter
+{
+    float alpha = 0.85f; // Share of position residual taken
+    float beta = 0.4f;   // Share of residual turned into velocity change
+    float resetDistance = 0.5f; // Residual above which the point is taken as teleported
+
+    Vec2 position;
+    Vec2 velocity;
+
+    void reset(const Vec2& newPosition)
+    {
+        position = newPosition;
+        velocity = Vec2();
+    }
+
+    void update(const Vec2& measured, float deltaTime)
+    {
+        if (deltaTime <= 0.0f)
+        {
+            reset(measured);
+            return;
+        }
+
+        const Vec2 predicted = position + velocity * deltaTime;
+        const Vec2 residual = measured - predicted;
+
+        // Maximized, snapped or moved to another monitor, old motion means nothing
+        if (residual.lengthSquared() > resetDistance * resetDistance)
+        {
+            reset(measured);
+            return;
+        }
+
+        position = predicted + residual * alpha;
+        velocity += residual * (beta / deltaTime);
+    }
+
+    Vec2 predict(float timeAhead) const
+    {
+        return position + velocity * timeAhead;
+    }
+};
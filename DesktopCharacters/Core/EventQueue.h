@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free bounded multiple producer / single consumer queue
+// Every slot carries a sequence number telling whose turn it is, so producers only contend
+// on the tail counter and the consumer never touches it. Never allocates; pushing into
+// a full queue drops the value and counts it.
+template<typename T, size_t Capacity>
+class EventQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+    EventQueue()
+    {
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // Producer side, any thread
+    // Returns false if the queue is full
+    bool push(const T& value)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = slots[position & MASK];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0)
+            {
+                // Slot is free, claim it; on failure position is reloaded
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Consumer hasn't freed this slot since last lap
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer side, one thread only
+    // Returns false if the queue is empty
+    bool pop(T& value)
+    {
+        Slot& slot = slots[head & MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+        {
+            return false;
+        }
+
+        value = slot.value;
+        slot.sequence.store(head + Capacity, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+    static constexpr size_t capacity() { return Capacity; }
+private:
+    static const size_t MASK = Capacity - 1;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot slots[Capacity];
+
+    // Apart so producers and consumer don't share a cache line
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) size_t head = 0;
+    std::atomic<uint64_t> droppedCount{ 0 };
+};
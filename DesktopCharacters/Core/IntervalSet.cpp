@@ -0,0 +1,200 @@
+#include "IntervalSet.h"
+
+#include <algorithm>
+
+IntervalSet::IntervalSet(const Range& range)
+{
+	insert(range);
+}
+
+IntervalSet::IntervalSet(IntervalSet&& other) noexcept :
+	heapItems(std::move(other.heapItems)), count(other.count), onHeap(other.onHeap)
+{
+	std::copy(other.inlineItems, other.inlineItems + INLINE_CAPACITY, inlineItems);
+	other.clear();
+}
+
+IntervalSet& IntervalSet::operator=(IntervalSet&& other) noexcept
+{
+	if (this != &other)
+	{
+		std::copy(other.inlineItems, other.inlineItems + INLINE_CAPACITY, inlineItems);
+		heapItems = std::move(other.heapItems);
+		count = other.count;
+		onHeap = other.onHeap;
+		other.clear();
+	}
+	return *this;
+}
+
+void IntervalSet::insert(const Range& range)
+{
+	if (range.min >= range.max)
+	{
+		return;
+	}
+
+	const size_t first = firstEndingAfter(range.min, true);
+	const size_t last = firstStartingAfter(range.max, false);
+
+	Range merged = range;
+	if (first < last)
+	{
+		const Range* items = data();
+		merged.min = std::min(merged.min, items[first].min);
+		merged.max = std::max(merged.max, items[last - 1].max);
+	}
+
+	splice(first, last, &merged, 1);
+}
+
+void IntervalSet::subtract(const Range& range)
+{
+	if (range.min >= range.max)
+	{
+		return;
+	}
+
+	const size_t first = firstEndingAfter(range.min, false);
+	const size_t last = firstStartingAfter(range.max, true);
+	if (first >= last)
+	{
+		return;
+	}
+
+	const Range* items = data();
+
+	Range pieces[2];
+	size_t piecesCount = 0;
+
+	// Left piece
+	if (items[first].min < range.min)
+	{
+		pieces[piecesCount++] = Range(items[first].min, range.min);
+	}
+
+	// Right piece
+	if (range.max < items[last - 1].max)
+	{
+		pieces[piecesCount++] = Range(range.max, items[last - 1].max);
+	}
+
+	splice(first, last, pieces, piecesCount);
+}
+
+void IntervalSet::closeGaps(float maxGap)
+{
+	if (count < 2)
+	{
+		return;
+	}
+
+	Range* items = data();
+	size_t last = 0;
+	for (size_t i = 1; i < count; i++)
+	{
+		if (items[i].min <= items[last].max + maxGap)
+		{
+			items[last].max = std::max(items[last].max, items[i].max);
+		}
+		else
+		{
+			items[++last] = items[i];
+		}
+	}
+
+	count = (uint32_t)(last + 1);
+	if (onHeap)
+	{
+		heapItems.resize(count);
+	}
+}
+
+bool IntervalSet::findOverlap(float min, float max, size_t& index) const
+{
+	index = firstEndingAfter(min, false);
+	return index < count && data()[index].min < max;
+}
+
+void IntervalSet::clear()
+{
+	count = 0;
+	heapItems.clear();
+	onHeap = false;
+}
+
+size_t IntervalSet::firstEndingAfter(float value, bool inclusive) const
+{
+	const Range* items = data();
+	auto isBefore = [value, inclusive](const Range& item) { return inclusive ? item.max < value : item.max <= value; };
+
+	if (count <= LINEAR_SEARCH_LIMIT)
+	{
+		size_t i = 0;
+		while (i < count && isBefore(items[i]))
+		{
+			i++;
+		}
+		return i;
+	}
+
+	return std::partition_point(items, items + count, isBefore) - items;
+}
+
+size_t IntervalSet::firstStartingAfter(float value, bool inclusive) const
+{
+	const Range* items = data();
+	auto isBefore = [value, inclusive](const Range& item) { return inclusive ? item.min < value : item.min <= value; };
+
+	if (count <= LINEAR_SEARCH_LIMIT)
+	{
+		size_t i = 0;
+		while (i < count && isBefore(items[i]))
+		{
+			i++;
+		}
+		return i;
+	}
+
+	return std::partition_point(items, items + count, isBefore) - items;
+}
+
+void IntervalSet::splice(size_t first, size_t last, const Range* items, size_t itemsCount)
+{
+	const size_t removed = last - first;
+	const size_t newCount = count - removed + itemsCount;
+
+	if (!onHeap && newCount > INLINE_CAPACITY)
+	{
+		heapItems.assign(inlineItems, inlineItems + count);
+		onHeap = true;
+	}
+
+	if (onHeap)
+	{
+		if (itemsCount > removed)
+		{
+			heapItems.insert(heapItems.begin() + last, itemsCount - removed, Range());
+		}
+		else
+		{
+			heapItems.erase(heapItems.begin() + first + itemsCount, heapItems.begin() + last);
+		}
+		std::copy(items, items + itemsCount, heapItems.begin() + first);
+	}
+	else
+	{
+		// Shift tail into place, then fill the gap
+		if (itemsCount > removed)
+		{
+			std::copy_backward(inlineItems + last, inlineItems + count, inlineItems + newCount);
+		}
+		else
+		{
+			std::copy(inlineItems + last, inlineItems + count, inlineItems + first + itemsCount);
+		}
+		std::copy(items, items + itemsCount, inlineItems + first);
+	}
+
+	count = (uint32_t)newCount;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Range.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sorted set of disjoint intervals along one axis
+// First few intervals live inline, so a typical obstacle never touches the heap.
+// Searches are linear while the set is small and binary once it grows.
+class IntervalSet
+{
+public:
+	static const size_t INLINE_CAPACITY = 4;
+
+	IntervalSet() = default;
+	explicit IntervalSet(const Range& range);
+
+	IntervalSet(const IntervalSet& other) = default;
+	IntervalSet& operator=(const IntervalSet& other) = default;
+
+	// Source is left empty, with inline storage
+	IntervalSet(IntervalSet&& other) noexcept;
+	IntervalSet& operator=(IntervalSet&& other) noexcept;
+
+	// Union, touching or overlapping intervals are joined
+	void insert(const Range& range);
+
+	// Difference, intervals crossing range are cut, leaving up to two pieces
+	void subtract(const Range& range);
+
+	// Joins neighbouring intervals separated by at most maxGap
+	void closeGaps(float maxGap);
+
+	// First interval overlapping (min, max), open on both ends
+	bool findOverlap(float min, float max, size_t& index) const;
+
+	void clear();
+
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+
+	const Range* begin() const { return data(); }
+	const Range* end() const { return data() + count; }
+
+	const Range& operator[](size_t index) const { return data()[index]; }
+	const Range& front() const { return data()[0]; }
+	const Range& back() const { return data()[count - 1]; }
+private:
+	static const size_t LINEAR_SEARCH_LIMIT = 8;
+
+	Range inlineItems[INLINE_CAPACITY];
+	std::vector<Range> heapItems; // Used instead of inline items once they overflow, size equals count
+	uint32_t count = 0;
+	bool onHeap = false;
+
+	const Range* data() const { return onHeap ? heapItems.data() : inlineItems; }
+	Range* data() { return onHeap ? heapItems.data() : inlineItems; }
+
+	// Index of first interval with max above value (or at it, if inclusive)
+	size_t firstEndingAfter(float value, bool inclusive) const;
+	// Index of first interval with min above value (or at it, if inclusive)
+	size_t firstStartingAfter(float value, bool inclusive) const;
+
+	// Replaces intervals [first, last) with given ones
+	void splice(size_t first, size_t last, const Range* items, size_t itemsCount);
+};
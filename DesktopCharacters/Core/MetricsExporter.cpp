@@ -0,0 +1,85 @@
+#include "MetricsExporter.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool MetricsExporter::open(const std::string& newPath)
+{
+    path = newPath;
+    opened = write();
+    return opened;
+}
+
+bool MetricsExporter::isOpen() const
+{
+    return opened;
+}
+
+void MetricsExporter::set(const std::string& name, double value, Type type, const std::string& labels)
+{
+    std::string key = name + labels;
+
+    auto it = metricIndices.find(key);
+    if (it != metricIndices.end())
+    {
+        metrics[it->second].value = value;
+        return;
+    }
+
+    metricIndices[key] = metrics.size();
+    metrics.push_back({ name, labels, type, value });
+}
+
+bool MetricsExporter::write()
+{
+    if (path.empty())
+    {
+        return false;
+    }
+
+    // Counters keep every digit, default 6 would round them once they pass a million
+    std::ostringstream block;
+    block << std::setprecision(17);
+
+    const std::string* previousName = nullptr;
+    for (const Metric& metric : metrics)
+    {
+        if (previousName == nullptr || *previousName != metric.name)
+        {
+            block << "# TYPE " << metric.name << (metric.type == Type::Counter ? " counter" : " gauge") << "\n";
+            previousName = &metric.name;
+        }
+
+        block << metric.name;
+        if (!metric.labels.empty())
+        {
+            block << "{" << metric.labels << "}";
+        }
+        block << " " << metric.value << "\n";
+    }
+
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::trunc | std::ios::binary);
+        file << block.str();
+        if (!file.good())
+        {
+            std::cout << "Failed to write metrics file: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    // Replaces existing file in one step
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::cout << "Failed to replace metrics file " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
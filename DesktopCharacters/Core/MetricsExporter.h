@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Metrics in Prometheus text format, latest values only, for a textfile collector to scrape
+// Setting values only updates a table; formatting and file IO happen in write(),
+// which is meant to be called every few seconds, not every frame.
+class MetricsExporter
+{
+public:
+    enum class Type
+    {
+        Gauge,
+        Counter
+    };
+
+    // Writes an empty exposition right away, so a bad path is reported at startup
+    bool open(const std::string& path);
+    bool isOpen() const;
+
+    // Metric is created on first use; labels are in Prometheus form, e.g. quantile="0.5"
+    void set(const std::string& name, double value, Type type = Type::Gauge, const std::string& labels = "");
+
+    // Replaces file with current values of every metric
+    // Goes through path.tmp and a rename, so a scrape never sees a partly written file
+    bool write();
+private:
+    struct Metric
+    {
+        std::string name;
+        std::string labels;
+        Type type;
+        double value;
+    };
+
+    std::vector<Metric> metrics; // In creation order, so samples of one name stay together
+    std::unordered_map<std::string, size_t> metricIndices; // Key is name + labels
+
+    std::string path;
+    bool opened = false;
+};
@@ -1,7 +1,9 @@
 #include "Profiler.h"
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdlib>
 
 double Profiler::ProfileData::getAverageTime() const
 {
@@ -16,28 +18,69 @@ void Profiler::ProfileData::addSample(double time)
     callCount++;
 }
 
+void Profiler::ProfileData::merge(const ProfileData& other)
+{
+    totalTime += other.totalTime;
+    minTime = std::min(minTime, other.minTime);
+    maxTime = std::max(maxTime, other.maxTime);
+    callCount += other.callCount;
+    allocationCount += other.allocationCount;
+    allocationBytes += other.allocationBytes;
+}
+
 void Profiler::ProfileData::reset()
 {
     totalTime = 0.0;
     minTime = std::numeric_limits<double>::max();
     maxTime = 0.0;
     callCount = 0;
+    allocationCount = 0;
+    allocationBytes = 0;
 }
 
 // Static member definitions
-std::unordered_map<std::string, Profiler::ProfileData> Profiler::profileData;
-std::chrono::high_resolution_clock::time_point Profiler::frameStartTime;
+std::recursive_mutex Profiler::mutex;
+std::unordered_map<std::string, Profiler::ProfileData, Profiler::NameHash, std::equal_to<>> Profiler::profileData;
+std::unordered_map<std::string, Profiler::ProfileData> Profiler::counterData;
+std::function<uint64_t()> Profiler::clock;
+uint64_t Profiler::frameStartTime = 0;
 double Profiler::lastFrameTime = 0.0;
+RingBuffer<double, 1024> Profiler::recentFrameTimes;
+uint64_t Profiler::framesCount = 0;
+uint64_t Profiler::allocationViolationsCount = 0;
+bool Profiler::strictAllocations = false;
+thread_local ScopedProfiler* ScopedProfiler::current = nullptr;
+
+void Profiler::setClock(std::function<uint64_t()> newClock)
+{
+    clock = std::move(newClock);
+}
+
+uint64_t Profiler::now()
+{
+    if (clock)
+    {
+        return clock();
+    }
+
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
 
 void Profiler::beginFrame()
 {
-    frameStartTime = std::chrono::high_resolution_clock::now();
+    frameStartTime = now();
 }
 
 void Profiler::endFrame()
 {
-    auto frameEndTime = std::chrono::high_resolution_clock::now();
-    lastFrameTime = std::chrono::duration<double, std::milli>(frameEndTime - frameStartTime).count();
+    uint64_t frameEndTime = now();
+    lastFrameTime = (frameEndTime - frameStartTime) * 1e-6;
+
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    framesCount++;
+    recentFrameTimes.push(lastFrameTime);
 
     // Add frame time to profile data
     auto it = profileData.find("Frame Total");
@@ -53,6 +96,29 @@ void Profiler::endFrame()
     }
 }
 
+double Profiler::getFrameTimePercentile(double quantile, size_t maxFrames)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    const size_t count = std::min(recentFrameTimes.size(), maxFrames);
+    if (count == 0)
+    {
+        return 0.0;
+    }
+
+    const size_t first = recentFrameTimes.size() - count;
+    std::vector<double> sorted(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        sorted[i] = recentFrameTimes[first + i];
+    }
+
+    size_t index = (size_t)(quantile * (count - 1) + 0.5);
+    index = std::min(index, count - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
 void Profiler::beginProfile(const std::string& name)
 {
     // This method is kept for manual profiling if needed
@@ -65,14 +131,38 @@ void Profiler::endProfile(const std::string& name)
     // For most use cases, prefer ScopedProfiler
 }
 
+void Profiler::addCounterSamples(const std::string& name, const ProfileData& samples)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (samples.callCount == 0)
+    {
+        return;
+    }
+
+    counterData[name].merge(samples);
+}
+
+const Profiler::ProfileData* Profiler::getCounterData(const std::string& name)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto it = counterData.find(name);
+    return (it != counterData.end()) ? &it->second : nullptr;
+}
+
 const Profiler::ProfileData* Profiler::getProfileData(const std::string& name)
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     auto it = profileData.find(name);
     return (it != profileData.end()) ? &it->second : nullptr;
 }
 
 std::vector<std::pair<std::string, Profiler::ProfileData>> Profiler::getAllProfileData()
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     std::vector<std::pair<std::string, ProfileData>> result;
     result.reserve(profileData.size());
 
@@ -92,14 +182,45 @@ std::vector<std::pair<std::string, Profiler::ProfileData>> Profiler::getAllProfi
 
 void Profiler::resetAllProfiles()
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     for (auto& pair : profileData)
     {
         pair.second.reset();
     }
+    for (auto& pair : counterData)
+    {
+        pair.second.reset();
+    }
+}
+
+uint64_t Profiler::getAllocationViolationsCount()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return allocationViolationsCount;
+}
+
+void Profiler::setStrictAllocations(bool strict)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    strictAllocations = strict;
+}
+
+// Must not allocate or lock, runs inside operator new
+void Profiler::recordAllocation(size_t bytes)
+{
+    ScopedProfiler* zone = ScopedProfiler::current;
+    if (zone)
+    {
+        zone->allocationCount++;
+        zone->allocationBytes += bytes;
+    }
 }
 
 void Profiler::printProfileReport()
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     std::ios oldState(nullptr);
     oldState.copyfmt(std::cout);
 
@@ -111,7 +232,12 @@ void Profiler::printProfileReport()
         << std::setw(12) << "Min (ms)"
         << std::setw(12) << "Max (ms)"
         << std::setw(15) << "Total (ms)"
-        << std::setw(10) << "Calls" << "\n";
+        << std::setw(10) << "Calls"
+#ifdef PROFILE_ALLOCATIONS
+        << std::setw(14) << "Allocs/frame"
+        << std::setw(14) << "Bytes/frame"
+#endif
+        << "\n";
     std::cout << std::string(100, '-') << "\n";
 
     auto sortedData = getAllProfileData();
@@ -143,6 +269,17 @@ void Profiler::printProfileReport()
             << std::setw(15) << data.totalTime
             << std::setw(10) << data.callCount;
 
+#ifdef PROFILE_ALLOCATIONS
+        {
+            const ProfileData* frames = getProfileData("Frame Total");
+            double framesMeasured = (frames && frames->callCount > 0) ? (double)frames->callCount : 1.0;
+            std::cout << std::setprecision(1)
+                << std::setw(14) << data.allocationCount / framesMeasured
+                << std::setw(14) << data.allocationBytes / framesMeasured
+                << std::setprecision(4);
+        }
+#endif
+
         // Show percentage of total frame time if we have frame data
         const ProfileData* frameData = getProfileData("Frame Total");
         if (frameData && frameData->totalTime > 0.0 && name != "Frame Total")
@@ -185,30 +322,91 @@ void Profiler::printProfileReport()
         }
     }
 
+#ifdef PROFILE_ALLOCATIONS
+    std::cout << "  Allocation-free zone violations: " << allocationViolationsCount << "\n";
+#endif
+
+    // Counters
+    bool hasCounters = false;
+    for (const auto& pair : counterData)
+    {
+        hasCounters |= pair.second.callCount > 0;
+    }
+
+    if (hasCounters)
+    {
+        std::cout << std::string(100, '-') << "\n";
+        std::cout << std::setw(30) << "Counter"
+            << std::setw(12) << "Avg"
+            << std::setw(12) << "Min"
+            << std::setw(12) << "Max"
+            << std::setw(15) << "Total"
+            << std::setw(10) << "Samples" << "\n";
+
+        for (const auto& pair : counterData)
+        {
+            const ProfileData& data = pair.second;
+            if (data.callCount == 0)
+            {
+                continue;
+            }
+
+            std::cout << std::setw(30) << pair.first.substr(0, 29)
+                << std::setw(12) << std::setprecision(2) << data.getAverageTime()
+                << std::setw(12) << std::setprecision(0) << data.minTime
+                << std::setw(12) << data.maxTime
+                << std::setw(15) << data.totalTime
+                << std::setw(10) << data.callCount << "\n";
+        }
+    }
+
     std::cout << std::string(100, '=') << std::endl;
 
     std::cout.copyfmt(oldState);
 }
 
-ScopedProfiler::ScopedProfiler(const std::string& profileName) : name(profileName)
+ScopedProfiler::ScopedProfiler(const char* profileName, bool allocationFree) :
+    name(profileName), allocationFree(allocationFree), parent(current)
 {
-    startTime = std::chrono::high_resolution_clock::now();
+    current = this;
+    startTime = Profiler::now();
 }
 
 ScopedProfiler::~ScopedProfiler()
 {
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    uint64_t endTime = Profiler::now();
+    double duration = (endTime - startTime) * 1e-6;
 
+    // Bookkeeping below counts towards parent zone
+    current = parent;
+    if (parent)
+    {
+        parent->allocationCount += allocationCount;
+        parent->allocationBytes += allocationBytes;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(Profiler::mutex);
+
+    // Only first exit of a zone inserts, and allocates
     auto it = Profiler::profileData.find(name);
-    if (it != Profiler::profileData.end())
+    if (it == Profiler::profileData.end())
     {
-        it->second.addSample(duration);
+        it = Profiler::profileData.emplace(name, Profiler::ProfileData()).first;
     }
-    else
+    Profiler::ProfileData& data = it->second;
+    data.addSample(duration);
+    data.allocationCount += allocationCount;
+    data.allocationBytes += allocationBytes;
+
+    if (allocationFree && allocationCount > 0 && Profiler::framesCount >= Profiler::ALLOCATION_WARMUP_FRAMES)
     {
-        Profiler::ProfileData data;
-        data.addSample(duration);
-        Profiler::profileData[name] = data;
+        Profiler::allocationViolationsCount++;
+        std::cout << "Allocation-free zone '" << name << "' made " << allocationCount
+            << " allocations (" << allocationBytes << " bytes)" << std::endl;
+
+        if (Profiler::strictAllocations)
+        {
+            std::abort();
+        }
     }
 }
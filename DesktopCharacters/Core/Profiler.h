@@ -1,9 +1,17 @@
 #pragma once
-#include <chrono>
+// Define PROFILE_ALLOCATIONS to count heap allocations per zone,
+// global operator new/delete are then replaced in AllocationTracking.cpp
+
+#include <cstdint>
+#include <functional>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <limits>
+#include <mutex>
+
+#include "RingBuffer.h"
 
 #undef max
 #undef min
@@ -18,47 +26,104 @@ public:
         double maxTime = 0.0;
         uint64_t callCount = 0;
 
+        // Heap allocations made inside the zone, nested zones included
+        uint64_t allocationCount = 0;
+        uint64_t allocationBytes = 0;
+
         double getAverageTime() const;
         void addSample(double time);
+        void merge(const ProfileData& other);
         void reset();
     };
 
 private:
-    static std::unordered_map<std::string, ProfileData> profileData;
-    static std::chrono::high_resolution_clock::time_point frameStartTime;
+    // Zones are recorded from several threads
+    static std::recursive_mutex mutex;
+
+    // Zones look up their data by const char* name, without building a string
+    struct NameHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+    };
+
+    static std::unordered_map<std::string, ProfileData, NameHash, std::equal_to<>> profileData;
+    static std::unordered_map<std::string, ProfileData> counterData; // Same statistics, but for plain values
+    static std::function<uint64_t()> clock; // Nanoseconds
+    static uint64_t frameStartTime;
     static double lastFrameTime;
+    static uint64_t framesCount; // Never reset
+    static RingBuffer<double, 1024> recentFrameTimes; // Kept through resets, for percentiles
+
+    static uint64_t now();
 
 public:
+    // Clock must be monotonic and return nanoseconds, set it before any zone is recorded
+    static void setClock(std::function<uint64_t()> newClock);
+
     static void beginFrame();
     static void endFrame();
     static double getLastFrameTime() { return lastFrameTime; }
 
+    // Frame time in milliseconds at given quantile (0..1) over up to maxFrames most recent frames
+    static double getFrameTimePercentile(double quantile, size_t maxFrames = SIZE_MAX);
+
     static void beginProfile(const std::string& name);
     static void endProfile(const std::string& name);
 
+    // Counters record values that aren't times (iterations, sizes, ...)
+    // Samples are usually accumulated locally and merged once per step
+    static void addCounterSamples(const std::string& name, const ProfileData& samples);
+    static const ProfileData* getCounterData(const std::string& name);
+
     static const ProfileData* getProfileData(const std::string& name);
     static std::vector<std::pair<std::string, ProfileData>> getAllProfileData();
 
     static void resetAllProfiles();
     static void printProfileReport();
 
+    // Allocation-free zones that allocated after warm-up frames
+    // Strict mode aborts on first violation, for test runs
+    static uint64_t getAllocationViolationsCount();
+    static void setStrictAllocations(bool strict);
+
+    // Called by operator new, attributes allocation to innermost open zone of this thread
+    static void recordAllocation(size_t bytes);
+
     // Allow ScopedProfiler access to private members
     friend class ScopedProfiler;
+private:
+    static const uint64_t ALLOCATION_WARMUP_FRAMES = 120; // Caches and scratch buffers grow during these
+    static uint64_t allocationViolationsCount;
+    static bool strictAllocations;
 };
 
 // RAII helper class for automatic profiling
 class ScopedProfiler
 {
 private:
-    std::string name;
-    std::chrono::high_resolution_clock::time_point startTime;
+    const char* name; // Literal, so entering a zone never allocates
+    uint64_t startTime;
+
+    // Allocations, counted only with PROFILE_ALLOCATIONS
+    bool allocationFree;
+    uint64_t allocationCount = 0;
+    uint64_t allocationBytes = 0;
+    ScopedProfiler* parent;
+    static thread_local ScopedProfiler* current;
 
 public:
-    ScopedProfiler(const std::string& profileName);
+    ScopedProfiler(const char* profileName, bool allocationFree = false);
 
     ~ScopedProfiler();
+
+    friend class Profiler;
 };
 
 // Convenience macros for easy profiling
 #define PROFILE_SCOPE(name) ScopedProfiler _prof(name)
-#define PROFILE_FUNCTION() ScopedProfiler _prof(__FUNCTION__)
\ No newline at end of file
+#define PROFILE_FUNCTION() ScopedProfiler _prof(__FUNCTION__)
+
+// Same, but zone must not allocate once warmed up
+#define PROFILE_SCOPE_NO_ALLOC(name) ScopedProfiler _prof(name, true)
+#define PROFILE_FUNCTION_NO_ALLOC() ScopedProfiler _prof(__FUNCTION__, true)
\ No newline at end of file
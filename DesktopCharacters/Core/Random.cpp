@@ -1,5 +1,7 @@
 #include "Random.h"
 
+#include <sstream>
+
 std::mt19937& Random::GetEngine()
 {
     static std::random_device rd;
@@ -18,3 +20,23 @@ float Random::Float(float min, float max)
     std::uniform_real_distribution<float> dist(min, max);
     return dist(GetEngine());
 }
+
+std::string Random::GetState()
+{
+    std::ostringstream stream;
+    stream << GetEngine();
+    return stream.str();
+}
+
+bool Random::SetState(const std::string& state)
+{
+    std::istringstream stream(state);
+    std::mt19937 engine;
+    if (!(stream >> engine))
+    {
+        return false;
+    }
+
+    GetEngine() = engine;
+    return true;
+}
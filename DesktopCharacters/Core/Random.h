@@ -1,5 +1,6 @@
 #pragma once
 #include <random>
+#include <string>
 
 class Random
 {
@@ -8,6 +9,10 @@ public:
 
     static int Int(int min, int max);
     static float Float(float min, float max);
+
+    // Engine state as text, for saving and restoring
+    static std::string GetState();
+    static bool SetState(const std::string& state);
 private:
     static std::mt19937& GetEngine();
 };
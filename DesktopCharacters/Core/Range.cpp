@@ -1,11 +0,0 @@
-#include "Range.h"
-
-Range::Range() :
-	min(0.0f), max(0.0f)
-{
-}
-
-Range::Range(float min, float max) :
-	min(min), max(max)
-{
-}
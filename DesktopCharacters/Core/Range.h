@@ -1,10 +1,15 @@
 #pragma once
+#undef min
+#undef max
+
+#include <type_traits>
 
 struct Range
 {
 	float min, max;
 
-	Range();
-	Range(float min, float max);
+	constexpr Range() : min(0.0f), max(0.0f) {}
+	constexpr Range(float min, float max) : min(min), max(max) {}
 };
 
+static_assert(std::is_trivially_copyable<Range>::value, "Range must stay trivially copyable");
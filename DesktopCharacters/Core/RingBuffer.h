@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+
+// Fixed capacity circular buffer, pushing into a full buffer overwrites the oldest element
+// Never allocates; index 0 is the oldest element
+template<typename T, size_t Capacity>
+class RingBuffer
+{
+public:
+    void push(const T& value)
+    {
+        items[(start + count) % Capacity] = value;
+        if (count < Capacity)
+        {
+            count++;
+        }
+        else
+        {
+            start = (start + 1) % Capacity;
+        }
+    }
+
+    // Removes n oldest elements
+    void popFront(size_t n = 1)
+    {
+        n = n < count ? n : count;
+        start = (start + n) % Capacity;
+        count -= n;
+    }
+
+    void clear()
+    {
+        start = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    const T& operator[](size_t index) const { return items[(start + index) % Capacity]; }
+    T& operator[](size_t index) { return items[(start + index) % Capacity]; }
+
+    const T& front() const { return (*this)[0]; }
+    const T& back() const { return (*this)[count - 1]; }
+private:
+    T items[Capacity];
+    size_t start = 0;
+    size_t count = 0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer
+// Writer fills its private buffer and publishes it; reader always gets the newest published one.
+// Neither side ever waits, buffers are reused so their allocations survive between frames.
+template<typename T>
+class TripleBuffer
+{
+public:
+    // Writer side
+    T& getWriteBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    void publish()
+    {
+        uint8_t previous = shared.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side
+    // Returns false if nothing was published since last call
+    bool acquire()
+    {
+        if ((shared.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+        {
+            return false;
+        }
+
+        uint8_t previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& getReadBuffer() const
+    {
+        return buffers[readIndex];
+    }
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH_BIT = 0x4;
+
+    T buffers[3];
+
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 1;
+    std::atomic<uint8_t> shared{ 2 };
+};
@@ -1,52 +1,62 @@
 #pragma once
+#include <cmath>
+#include <type_traits>
 
 // 2D Vector class for handling positions, velocities, and sizes
+// Header-only, so arithmetic in hot loops is inlined without LTO
 class Vec2
 {
 public:
     float x, y;
 
     // Constructors
-    Vec2();
-    Vec2(float x, float y);
-    Vec2(int x, int y);
+    constexpr Vec2() : x(0.0f), y(0.0f) {}
+    constexpr Vec2(float x, float y) : x(x), y(y) {}
+    constexpr Vec2(int x, int y) : x(static_cast<float>(x)), y(static_cast<float>(y)) {}
 
     // Arithmetic operators
-    Vec2 operator+(const Vec2& other) const;
-    Vec2 operator-(const Vec2& other) const;
-    Vec2 operator*(const Vec2& other) const;
-    Vec2 operator/(const Vec2& other) const;
+    constexpr Vec2 operator+(const Vec2& other) const { return Vec2(x + other.x, y + other.y); }
+    constexpr Vec2 operator-(const Vec2& other) const { return Vec2(x - other.x, y - other.y); }
+    constexpr Vec2 operator*(const Vec2& other) const { return Vec2(x * other.x, y * other.y); }
+    constexpr Vec2 operator/(const Vec2& other) const { return Vec2(x / other.x, y / other.y); }
 
-    Vec2 operator+(float scalar) const;
-    Vec2 operator-(float scalar) const;
-    Vec2 operator*(float scalar) const;
-    Vec2 operator/(float scalar) const;
+    constexpr Vec2 operator+(float scalar) const { return Vec2(x + scalar, y + scalar); }
+    constexpr Vec2 operator-(float scalar) const { return Vec2(x - scalar, y - scalar); }
+    constexpr Vec2 operator*(float scalar) const { return Vec2(x * scalar, y * scalar); }
+    constexpr Vec2 operator/(float scalar) const { return Vec2(x / scalar, y / scalar); }
 
-    Vec2 operator-() const;
+    constexpr Vec2 operator-() const { return Vec2(-x, -y); }
 
     // Assignment operators
-    Vec2& operator+=(const Vec2& other);
-    Vec2& operator-=(const Vec2& other);
-    Vec2& operator*=(const Vec2& other);
-    Vec2& operator/=(const Vec2& other);
+    constexpr Vec2& operator+=(const Vec2& other) { x += other.x; y += other.y; return *this; }
+    constexpr Vec2& operator-=(const Vec2& other) { x -= other.x; y -= other.y; return *this; }
+    constexpr Vec2& operator*=(const Vec2& other) { x *= other.x; y *= other.y; return *this; }
+    constexpr Vec2& operator/=(const Vec2& other) { x /= other.x; y /= other.y; return *this; }
 
-    Vec2& operator+=(float scalar);
-    Vec2& operator-=(float scalar);
-    Vec2& operator*=(float scalar);
-    Vec2& operator/=(float scalar);
+    constexpr Vec2& operator+=(float scalar) { x += scalar; y += scalar; return *this; }
+    constexpr Vec2& operator-=(float scalar) { x -= scalar; y -= scalar; return *this; }
+    constexpr Vec2& operator*=(float scalar) { x *= scalar; y *= scalar; return *this; }
+    constexpr Vec2& operator/=(float scalar) { x /= scalar; y /= scalar; return *this; }
 
     // Comparison operators
-    bool operator==(const Vec2& other) const;
-    bool operator!=(const Vec2& other) const;
+    constexpr bool operator==(const Vec2& other) const { return x == other.x && y == other.y; }
+    constexpr bool operator!=(const Vec2& other) const { return !(*this == other); }
 
     // Utility methods
-    float length() const;
-    float lengthSquared() const;
-    Vec2 normalized() const;
-    void normalize();
+    float length() const { return std::sqrt(x * x + y * y); }
+    constexpr float lengthSquared() const { return x * x + y * y; }
+    Vec2 normalized() const
+    {
+        float len = length();
+        return len > 0 ? *this / len : Vec2();
+    }
+    void normalize() { *this = normalized(); }
 
     // Static utility methods
-    static float distance(const Vec2& a, const Vec2& b);
-    static float distanceSquared(const Vec2& a, const Vec2& b);
-    static Vec2 lerp(const Vec2& a, const Vec2& b, float t);
-};
\ No newline at end of file
+    static float distance(const Vec2& a, const Vec2& b) { return (b - a).length(); }
+    static constexpr float distanceSquared(const Vec2& a, const Vec2& b) { return (b - a).lengthSquared(); }
+    static constexpr Vec2 lerp(const Vec2& a, const Vec2& b, float t) { return a + (b - a) * t; }
+};
+
+static_assert(std::is_trivially_copyable<Vec2>::value, "Vec2 must stay trivially copyable");
+static_assert(sizeof(Vec2) == 2 * sizeof(float), "Vec2 must be two packed floats");
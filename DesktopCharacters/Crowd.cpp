@@ -0,0 +1,406 @@
+#include "Crowd.h"
+
+#include "Character.h"
+#include "Core/Profiler.h"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Don't spawn a thread for less work than this
+static const size_t MIN_BODIES_PER_THREAD = 16384;
+
+// Tolerance for bodies resting exactly on a surface
+static const float CONTACT_EPSILON = 1e-4f;
+
+// Spatial reordering of bodies
+static const float REORDER_CELL_SIZE = 0.25f;
+static const int REORDER_PERIOD = 30; // In steps
+
+// mask ? a : b
+static inline __m128 blend(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline float horizontalMin(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float horizontalMax(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+// Segments with perpOffset inside [min, max]
+template<typename It>
+static inline std::pair<It, It> segmentsInRange(It begin, It end, float min, float max)
+{
+    auto first = std::lower_bound(begin, end, min,
+        [](const auto& segment, float value) { return segment.perpOffset < value; });
+    auto last = std::upper_bound(first, end, max,
+        [](float value, const auto& segment) { return value < segment.perpOffset; });
+    return { first, last };
+}
+
+static void scatter(std::vector<float>& values, const std::vector<uint32_t>& destination, std::vector<float>& scratch)
+{
+    const size_t count = destination.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        scratch[destination[i]] = values[i];
+    }
+    std::copy(scratch.begin(), scratch.begin() + count, values.begin());
+}
+
+Crowd::Crowd()
+{
+}
+
+Crowd::Crowd(const Data& data) :
+    data(data)
+{
+}
+
+Crowd::~Crowd()
+{
+    stopWorkers();
+}
+
+void Crowd::addBody(const Vec2& position, const Vec2& velocity)
+{
+    // Grow padding by a whole chunk
+    if (count == positionX.size())
+    {
+        size_t newSize = positionX.size() + 4;
+        positionX.resize(newSize, position.x);
+        positionY.resize(newSize, position.y);
+        velocityX.resize(newSize, 0.0f);
+        velocityY.resize(newSize, 0.0f);
+    }
+
+    positionX[count] = position.x;
+    positionY[count] = position.y;
+    velocityX[count] = velocity.x;
+    velocityY[count] = velocity.y;
+    count++;
+}
+
+void Crowd::clear()
+{
+    count = 0;
+    positionX.clear();
+    positionY.clear();
+    velocityX.clear();
+    velocityY.clear();
+}
+
+void Crowd::update(float deltaTime, const WorldSnapshot& world)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (world.version != flattenedVersion)
+    {
+        PROFILE_SCOPE("Crowd flatten obstacles");
+        flattenObstacles(world);
+    }
+
+    if (--stepsUntilReorder <= 0)
+    {
+        PROFILE_SCOPE("Crowd reorder");
+        reorderBodies();
+        stepsUntilReorder = REORDER_PERIOD;
+    }
+
+    PROFILE_SCOPE("Crowd integrate");
+
+    const size_t paddedCount = positionX.size();
+    const size_t chunksCount = paddedCount / 4;
+
+    size_t threads = std::min<size_t>(threadCount, paddedCount / MIN_BODIES_PER_THREAD);
+    if (threads <= 1)
+    {
+        updateRange(0, paddedCount, deltaTime);
+        return;
+    }
+
+    // Every thread gets a whole number of chunks
+    std::unique_lock<std::mutex> lock(workMutex);
+    while (workers.size() < threads - 1)
+    {
+        workers.emplace_back(&Crowd::workerLoop, this, workers.size());
+    }
+
+    workRangesCount = threads;
+    workChunksPerRange = (chunksCount + threads - 1) / threads;
+    workDeltaTime = deltaTime;
+    workersBusy = workers.size();
+    workGeneration++;
+    lock.unlock();
+    workStarted.notify_all();
+
+    updateRangeOfThread(0);
+
+    lock.lock();
+    workFinished.wait(lock, [this]() { return workersBusy == 0; });
+}
+
+void Crowd::setThreadCount(unsigned newThreadCount)
+{
+    threadCount = std::max(newThreadCount, 1u);
+}
+
+size_t Crowd::getCount() const
+{
+    return count;
+}
+
+Vec2 Crowd::getPosition(size_t index) const
+{
+    return Vec2(positionX[index], positionY[index]);
+}
+
+Vec2 Crowd::getVelocity(size_t index) const
+{
+    return Vec2(velocityX[index], velocityY[index]);
+}
+
+const Crowd::Data& Crowd::getData() const
+{
+    return data;
+}
+
+void Crowd::flattenObstacles(const WorldSnapshot& world)
+{
+    flattenedVersion = world.version;
+    worldSize = world.size;
+
+    horizontalSegments.clear();
+    verticalSegments.clear();
+
+    for (const auto& obstacle : world.obstacles)
+    {
+        auto& target = obstacle.type == Obstacle::Type::Horizontal ? horizontalSegments : verticalSegments;
+        for (const auto& segment : obstacle.segments)
+        {
+            target.push_back({ obstacle.perpOffset, segment.min, segment.max });
+        }
+    }
+
+    auto byPerpOffset = [](const Segment& a, const Segment& b) { return a.perpOffset < b.perpOffset; };
+    std::sort(horizontalSegments.begin(), horizontalSegments.end(), byPerpOffset);
+    std::sort(verticalSegments.begin(), verticalSegments.end(), byPerpOffset);
+}
+
+// Counting sort of bodies by grid cell, padding stays at the end
+void Crowd::reorderBodies()
+{
+    const int columns = std::max(1, (int)ceilf(worldSize.x * 2.0f / REORDER_CELL_SIZE));
+    const int rows = std::max(1, (int)ceilf(worldSize.y * 2.0f / REORDER_CELL_SIZE));
+
+    cellStart.assign((size_t)columns * rows + 1, 0);
+    bodyCell.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int column = (int)((positionX[i] + worldSize.x) / REORDER_CELL_SIZE);
+        int row = (int)((positionY[i] + worldSize.y) / REORDER_CELL_SIZE);
+        column = std::min(std::max(column, 0), columns - 1);
+        row = std::min(std::max(row, 0), rows - 1);
+
+        bodyCell[i] = (uint32_t)(row * columns + column);
+        cellStart[bodyCell[i] + 1]++;
+    }
+
+    for (size_t i = 1; i < cellStart.size(); i++)
+    {
+        cellStart[i] += cellStart[i - 1];
+    }
+
+    // Cell index -> destination index
+    for (size_t i = 0; i < count; i++)
+    {
+        bodyCell[i] = cellStart[bodyCell[i]]++;
+    }
+
+    scratch.resize(count);
+    scatter(positionX, bodyCell, scratch);
+    scatter(positionY, bodyCell, scratch);
+    scatter(velocityX, bodyCell, scratch);
+    scatter(velocityY, bodyCell, scratch);
+}
+
+// Integrates bodies [begin, end), both must be multiples of 4
+void Crowd::updateRange(size_t begin, size_t end, float deltaTime)
+{
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 gravityDt = _mm_set1_ps(Character::gravity.y * deltaTime);
+    const __m128 halfX = _mm_set1_ps(data.bodySize.x * 0.5f);
+    const __m128 halfY = _mm_set1_ps(data.bodySize.y * 0.5f);
+    const __m128 epsilon = _mm_set1_ps(CONTACT_EPSILON);
+    const __m128 elasticitySides = _mm_set1_ps(-data.collisionElasticitySides);
+    const __m128 elasticityRoof = _mm_set1_ps(-data.collisionElasticityRoof);
+    const __m128 friction = _mm_set1_ps(data.frictionFloor * deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (size_t i = begin; i < end; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(&positionX[i]);
+        __m128 py = _mm_loadu_ps(&positionY[i]);
+        __m128 vx = _mm_loadu_ps(&velocityX[i]);
+        __m128 vy = _mm_loadu_ps(&velocityY[i]);
+
+        // Gravity
+        vy = _mm_add_ps(vy, gravityDt);
+
+        // Move
+        const __m128 oldX = px;
+        const __m128 oldY = py;
+        px = _mm_add_ps(px, _mm_mul_ps(vx, dt));
+        py = _mm_add_ps(py, _mm_mul_ps(vy, dt));
+
+        // Floors and roofs
+        __m128 grounded = zero;
+        const __m128 oldBottom = _mm_sub_ps(oldY, halfY);
+        const __m128 oldTop = _mm_add_ps(oldY, halfY);
+
+        const auto horizontal = segmentsInRange(horizontalSegments.cbegin(), horizontalSegments.cend(),
+            horizontalMin(_mm_min_ps(oldBottom, _mm_sub_ps(py, halfY))) - CONTACT_EPSILON,
+            horizontalMax(_mm_max_ps(oldTop, _mm_add_ps(py, halfY))) + CONTACT_EPSILON);
+
+        for (auto it = horizontal.first; it != horizontal.second; ++it)
+        {
+            const Segment& segment = *it;
+            const __m128 perp = _mm_set1_ps(segment.perpOffset);
+
+            __m128 overlap = _mm_and_ps(
+                _mm_cmplt_ps(_mm_sub_ps(px, halfX), _mm_set1_ps(segment.max)),
+                _mm_cmpgt_ps(_mm_add_ps(px, halfX), _mm_set1_ps(segment.min)));
+
+            // Crossed the line going down
+            __m128 landed = _mm_and_ps(overlap, _mm_and_ps(
+                _mm_cmpge_ps(oldBottom, _mm_sub_ps(perp, epsilon)),
+                _mm_cmplt_ps(_mm_sub_ps(py, halfY), perp)));
+
+            py = blend(landed, _mm_add_ps(perp, halfY), py);
+            vy = blend(landed, zero, vy);
+            grounded = _mm_or_ps(grounded, landed);
+
+            // Crossed the line going up
+            __m128 bumped = _mm_and_ps(overlap, _mm_and_ps(
+                _mm_cmple_ps(oldTop, _mm_add_ps(perp, epsilon)),
+                _mm_cmpgt_ps(_mm_add_ps(py, halfY), perp)));
+
+            py = blend(bumped, _mm_sub_ps(perp, halfY), py);
+            vy = blend(bumped, _mm_mul_ps(vy, elasticityRoof), vy);
+        }
+
+        // Walls
+        const __m128 oldLeft = _mm_sub_ps(oldX, halfX);
+        const __m128 oldRight = _mm_add_ps(oldX, halfX);
+
+        const auto vertical = segmentsInRange(verticalSegments.cbegin(), verticalSegments.cend(),
+            horizontalMin(_mm_min_ps(oldLeft, _mm_sub_ps(px, halfX))) - CONTACT_EPSILON,
+            horizontalMax(_mm_max_ps(oldRight, _mm_add_ps(px, halfX))) + CONTACT_EPSILON);
+
+        for (auto it = vertical.first; it != vertical.second; ++it)
+        {
+            const Segment& segment = *it;
+            const __m128 perp = _mm_set1_ps(segment.perpOffset);
+
+            __m128 overlap = _mm_and_ps(
+                _mm_cmplt_ps(_mm_sub_ps(py, halfY), _mm_set1_ps(segment.max)),
+                _mm_cmpgt_ps(_mm_add_ps(py, halfY), _mm_set1_ps(segment.min)));
+
+            // Crossed the line going right
+            __m128 hitRight = _mm_and_ps(overlap, _mm_and_ps(
+                _mm_cmple_ps(oldRight, _mm_add_ps(perp, epsilon)),
+                _mm_cmpgt_ps(_mm_add_ps(px, halfX), perp)));
+
+            // Crossed the line going left
+            __m128 hitLeft = _mm_and_ps(overlap, _mm_and_ps(
+                _mm_cmpge_ps(oldLeft, _mm_sub_ps(perp, epsilon)),
+                _mm_cmplt_ps(_mm_sub_ps(px, halfX), perp)));
+
+            px = blend(hitRight, _mm_sub_ps(perp, halfX), px);
+            px = blend(hitLeft, _mm_add_ps(perp, halfX), px);
+            vx = blend(_mm_or_ps(hitRight, hitLeft), _mm_mul_ps(vx, elasticitySides), vx);
+        }
+
+        // Friction with floor
+        __m128 speed = _mm_andnot_ps(signMask, vx);
+        __m128 sign = _mm_and_ps(signMask, vx);
+        __m128 slowed = _mm_or_ps(_mm_max_ps(_mm_sub_ps(speed, friction), zero), sign);
+        vx = blend(grounded, slowed, vx);
+
+        _mm_storeu_ps(&positionX[i], px);
+        _mm_storeu_ps(&positionY[i], py);
+        _mm_storeu_ps(&velocityX[i], vx);
+        _mm_storeu_ps(&velocityY[i], vy);
+    }
+}
+
+// Range rangeIndex of the step workers were last handed, empty if the step has fewer ranges
+void Crowd::updateRangeOfThread(size_t rangeIndex)
+{
+    if (rangeIndex >= workRangesCount)
+    {
+        return;
+    }
+
+    const size_t chunksCount = positionX.size() / 4;
+    const size_t begin = std::min(rangeIndex * workChunksPerRange, chunksCount) * 4;
+    const size_t end = std::min((rangeIndex + 1) * workChunksPerRange, chunksCount) * 4;
+    updateRange(begin, end, workDeltaTime);
+}
+
+void Crowd::workerLoop(size_t workerIndex)
+{
+    uint64_t doneGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(workMutex);
+            workStarted.wait(lock, [&]() { return workersExit || workGeneration != doneGeneration; });
+            if (workersExit)
+            {
+                return;
+            }
+            doneGeneration = workGeneration;
+        }
+
+        updateRangeOfThread(workerIndex + 1);
+
+        {
+            std::lock_guard<std::mutex> lock(workMutex);
+            workersBusy--;
+        }
+        workFinished.notify_one();
+    }
+}
+
+void Crowd::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(workMutex);
+        workersExit = true;
+    }
+    workStarted.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+}
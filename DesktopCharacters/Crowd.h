@@ -0,0 +1,99 @@
+#pragma once
+#include "Core/Vec2.h"
+
+#include "Obstacle.h"
+#include "WorldSnapshot.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Crowd of lightweight physics bodies for stress displays
+// Bodies only fall, land on floors and bounce off walls; there is no follow logic.
+// State is stored as separate arrays and integrated with SSE, four bodies at a time.
+class Crowd
+{
+public:
+    struct Data
+    {
+        Vec2 bodySize = Vec2(0.05f, 0.05f);
+
+        float collisionElasticitySides = 0.0f;
+        float collisionElasticityRoof = 0.0f;
+
+        float frictionFloor = 0.0f; // Horizontal deceleration while grounded, per second
+    };
+
+    Crowd();
+    explicit Crowd(const Data& data);
+    ~Crowd();
+
+    Crowd(const Crowd&) = delete;
+    Crowd& operator=(const Crowd&) = delete;
+
+    void addBody(const Vec2& position, const Vec2& velocity);
+    void clear();
+
+    void update(float deltaTime, const WorldSnapshot& world);
+
+    // Bodies are split into ranges across threads when the crowd is large enough
+    // Worker threads are started on first use and kept until the crowd is destroyed
+    void setThreadCount(unsigned newThreadCount);
+
+    // Getters
+    size_t getCount() const;
+    Vec2 getPosition(size_t index) const;
+    Vec2 getVelocity(size_t index) const;
+    const Data& getData() const;
+private:
+    struct Segment
+    {
+        float perpOffset;
+        float min, max;
+    };
+
+    Data data;
+    unsigned threadCount = 1;
+
+    // Worker pool, worker i integrates range i + 1 of the current step, the calling thread range 0
+    std::vector<std::thread> workers;
+    std::mutex workMutex;
+    std::condition_variable workStarted;
+    std::condition_variable workFinished;
+    uint64_t workGeneration = 0; // Bumped for every step handed to workers
+    size_t workersBusy = 0;
+    bool workersExit = false;
+    size_t workRangesCount = 0;
+    size_t workChunksPerRange = 0;
+    float workDeltaTime = 0.0f;
+
+    // Arrays are padded to a multiple of 4, padding bodies are simulated but never exposed
+    size_t count = 0;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+
+    // Obstacles flattened from world snapshot, sorted by perpOffset
+    // Rebuilt only when snapshot version changes
+    uint64_t flattenedVersion = UINT64_MAX;
+    Vec2 worldSize;
+    std::vector<Segment> horizontalSegments;
+    std::vector<Segment> verticalSegments;
+
+    // Bodies are periodically reordered by grid cell, so every chunk of 4 covers a small area
+    // and only has to test the few segments crossing it
+    int stepsUntilReorder = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> bodyCell;
+    std::vector<float> scratch;
+
+    void flattenObstacles(const WorldSnapshot& world);
+    void reorderBodies();
+    void updateRange(size_t begin, size_t end, float deltaTime);
+    void updateRangeOfThread(size_t rangeIndex);
+    void workerLoop(size_t workerIndex);
+    void stopWorkers();
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include "Character.h"
+#include "Core/AffineTransform.h"
+#include "WorldSnapshot.h"
+
+#include <memory>
+#include <vector>
+
+// Everything render thread needs to draw one simulation frame
+// Filled by simulation and never changed after publishing
+struct FrameSnapshot
+{
+    struct CharacterState
+    {
+        AABB aabb;
+        Character::AnimationState animationState;
+        float animationTime;
+        bool facingLeft;
+    };
+
+    AffineTransform worldToScreen;
+
+    std::vector<CharacterState> characters;
+    std::vector<AABB> crowdBodies;
+
+    // Obstacles come straight from the pinned world snapshot
+    std::shared_ptr<const WorldSnapshot> world;
+    bool drawObstacles = true;
+};
@@ -0,0 +1,275 @@
+#include "JumpSolver.h"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Segments closer in height than this are on the same line
+static const float SAME_LINE_EPSILON = 1e-3f;
+
+// Part of body width that must end up over the target, grazing landings are missed by stepped motion
+static const float LANDING_OVERLAP_FRACTION = 0.1f;
+
+// mask ? a : b
+static inline __m128 blend(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+JumpSolver::JumpSolver(const Settings& newSettings)
+{
+    setSettings(newSettings);
+}
+
+void JumpSolver::setSettings(const Settings& newSettings)
+{
+    settings = newSettings;
+
+    // Velocity is changed by gravity before each step moves the body
+    arcVelocity = settings.maxJumpVelocity - settings.gravity * settings.stepTime * 0.5f;
+    inverseGravity = settings.gravity > 0.0f ? 1.0f / settings.gravity : 0.0f;
+    inverseSpeed = settings.maxSpeed > 0.0f ? 1.0f / settings.maxSpeed : 0.0f;
+    // Landing overlap is checked where the body was before the step, and stepped falls land up to half a step early
+    landingOverlap = settings.bodySize.x * LANDING_OVERLAP_FRACTION + settings.maxSpeed * settings.stepTime * 1.5f;
+}
+
+const JumpSolver::Settings& JumpSolver::getSettings() const
+{
+    return settings;
+}
+
+bool JumpSolver::solveJump(const Segment& from, const Segment& to, Launch& launch) const
+{
+    const float v = arcVelocity;
+    const float g = settings.gravity;
+    const float s = settings.maxSpeed;
+    const float height = to.y - from.y;
+    if (height <= SAME_LINE_EPSILON || v <= 0.0f || v * v <= 2.0f * g * height || s <= 0.0f || g <= 0.0f)
+    {
+        return false;
+    }
+
+    // Feet cross the target line going up, then coming down
+    const float root = sqrtf(v * v - 2.0f * g * height);
+    const float upTime = (v - root) * inverseGravity;
+    const float downTime = (v + root) * inverseGravity;
+
+    const float halfWidth = settings.bodySize.x * 0.5f;
+    const float landingMin = to.x.min + landingOverlap;
+    const float landingMax = to.x.max - landingOverlap;
+    const float fromCenter = (from.x.min + from.x.max) * 0.5f;
+
+    bool found = false;
+    float bestCost = 0.0f;
+    for (int side = 0; side < 2; side++)
+    {
+        // Approach from left (side 0) or from right
+        const float direction = side ? -1.0f : 1.0f;
+        const float edgeX = side ? to.x.max + halfWidth : to.x.min - halfWidth;
+        const float nearX = edgeX - direction * s * upTime;
+        const float farX = edgeX - direction * s * downTime;
+
+        // Takeoff must be on the segment, ideally halfway between both limits
+        const float minX = std::max(std::min(nearX, farX), from.x.min);
+        const float maxX = std::min(std::max(nearX, farX), from.x.max);
+        if (minX > maxX)
+        {
+            continue;
+        }
+
+        const float takeoffX = std::min(std::max((nearX + farX) * 0.5f, minX), maxX);
+
+        // Body must still be over the target when it comes down
+        const float landingX = takeoffX + direction * s * downTime;
+        if (landingX - halfWidth >= landingMax || landingX + halfWidth <= landingMin)
+        {
+            continue;
+        }
+
+        const float cost = downTime + fabsf(takeoffX - fromCenter) * inverseSpeed;
+        if (!found || cost < bestCost)
+        {
+            launch.takeoffX = takeoffX;
+            launch.velocity = Vec2(direction * s, settings.maxJumpVelocity);
+            launch.time = downTime;
+            bestCost = cost;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool JumpSolver::solveDrop(const Segment& from, float side, const Segment& to, Launch& launch) const
+{
+    const float height = from.y - to.y;
+    if (height <= SAME_LINE_EPSILON || settings.gravity <= 0.0f)
+    {
+        return false;
+    }
+
+    const float halfWidth = settings.bodySize.x * 0.5f;
+    const float takeoffX = getDropTakeoffX(from, side);
+    const float fallTime = sqrtf(2.0f * height * inverseGravity);
+    const float landingX = takeoffX + side * settings.maxSpeed * fallTime;
+
+    if (landingX - halfWidth >= to.x.max - landingOverlap || landingX + halfWidth <= to.x.min + landingOverlap)
+    {
+        return false;
+    }
+
+    launch.takeoffX = takeoffX;
+    launch.velocity = Vec2(side * settings.maxSpeed, 0.0f);
+    launch.time = fallTime;
+    return true;
+}
+
+// Lanes follow solveJump() step by step, both sides are solved and the cheaper valid one is kept
+void JumpSolver::solveJumps(const Segment& from, const Segments& targets, float* takeoffX, float* velocityX, float* time) const
+{
+    const float v = arcVelocity;
+    const float g = settings.gravity;
+    const float s = settings.maxSpeed;
+
+    const __m128 fromY = _mm_set1_ps(from.y);
+    const __m128 fromMin = _mm_set1_ps(from.x.min);
+    const __m128 fromMax = _mm_set1_ps(from.x.max);
+    const __m128 fromCenter = _mm_set1_ps((from.x.min + from.x.max) * 0.5f);
+    const __m128 jumpVelocity = _mm_set1_ps(v);
+    const __m128 jumpVelocitySquared = _mm_set1_ps(v * v);
+    const __m128 invGravity = _mm_set1_ps(inverseGravity);
+    const __m128 invSpeed = _mm_set1_ps(inverseSpeed);
+    const __m128 overlap = _mm_set1_ps(landingOverlap);
+    const __m128 twoGravity = _mm_set1_ps(2.0f * g);
+    const __m128 speed = _mm_set1_ps(s);
+    const __m128 halfWidth = _mm_set1_ps(settings.bodySize.x * 0.5f);
+    const __m128 epsilon = _mm_set1_ps(SAME_LINE_EPSILON);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 none = _mm_set1_ps(-1.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 settingsValid = v > 0.0f && s > 0.0f && g > 0.0f ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+
+    size_t i = 0;
+    for (; i + 4 <= targets.count; i += 4)
+    {
+        const __m128 toY = _mm_loadu_ps(&targets.y[i]);
+        const __m128 toMin = _mm_loadu_ps(&targets.minX[i]);
+        const __m128 toMax = _mm_loadu_ps(&targets.maxX[i]);
+        const __m128 landingMin = _mm_add_ps(toMin, overlap);
+        const __m128 landingMax = _mm_sub_ps(toMax, overlap);
+
+        const __m128 height = _mm_sub_ps(toY, fromY);
+        const __m128 discriminant = _mm_sub_ps(jumpVelocitySquared, _mm_mul_ps(twoGravity, height));
+        const __m128 valid = _mm_and_ps(settingsValid, _mm_and_ps(_mm_cmpgt_ps(height, epsilon), _mm_cmpgt_ps(discriminant, zero)));
+
+        const __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        const __m128 upTime = _mm_mul_ps(_mm_sub_ps(jumpVelocity, root), invGravity);
+        const __m128 downTime = _mm_mul_ps(_mm_add_ps(jumpVelocity, root), invGravity);
+        const __m128 upDistance = _mm_mul_ps(speed, upTime);
+        const __m128 downDistance = _mm_mul_ps(speed, downTime);
+
+        // Approach from left, takeoff in [farX, nearX]
+        const __m128 leftEdge = _mm_sub_ps(toMin, halfWidth);
+        const __m128 leftNear = _mm_sub_ps(leftEdge, upDistance);
+        const __m128 leftFar = _mm_sub_ps(leftEdge, downDistance);
+        const __m128 leftMin = _mm_max_ps(leftFar, fromMin);
+        const __m128 leftMax = _mm_min_ps(leftNear, fromMax);
+        const __m128 leftTakeoff = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(leftNear, leftFar), half), leftMin), leftMax);
+        const __m128 leftLanding = _mm_add_ps(leftTakeoff, downDistance);
+        const __m128 leftValid = _mm_and_ps(_mm_cmple_ps(leftMin, leftMax), _mm_and_ps(
+            _mm_cmplt_ps(_mm_sub_ps(leftLanding, halfWidth), landingMax),
+            _mm_cmpgt_ps(_mm_add_ps(leftLanding, halfWidth), landingMin)));
+        const __m128 leftCost = _mm_add_ps(downTime, _mm_mul_ps(_mm_and_ps(_mm_sub_ps(leftTakeoff, fromCenter), absMask), invSpeed));
+
+        // Approach from right, takeoff in [nearX, farX]
+        const __m128 rightEdge = _mm_add_ps(toMax, halfWidth);
+        const __m128 rightNear = _mm_add_ps(rightEdge, upDistance);
+        const __m128 rightFar = _mm_add_ps(rightEdge, downDistance);
+        const __m128 rightMin = _mm_max_ps(rightNear, fromMin);
+        const __m128 rightMax = _mm_min_ps(rightFar, fromMax);
+        const __m128 rightTakeoff = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(rightNear, rightFar), half), rightMin), rightMax);
+        const __m128 rightLanding = _mm_sub_ps(rightTakeoff, downDistance);
+        const __m128 rightValid = _mm_and_ps(_mm_cmple_ps(rightMin, rightMax), _mm_and_ps(
+            _mm_cmplt_ps(_mm_sub_ps(rightLanding, halfWidth), landingMax),
+            _mm_cmpgt_ps(_mm_add_ps(rightLanding, halfWidth), landingMin)));
+        const __m128 rightCost = _mm_add_ps(downTime, _mm_mul_ps(_mm_and_ps(_mm_sub_ps(rightTakeoff, fromCenter), absMask), invSpeed));
+
+        const __m128 useRight = _mm_and_ps(rightValid, _mm_or_ps(_mm_cmpeq_ps(leftValid, zero), _mm_cmplt_ps(rightCost, leftCost)));
+        const __m128 reachable = _mm_and_ps(valid, _mm_or_ps(leftValid, rightValid));
+
+        _mm_storeu_ps(&takeoffX[i], blend(useRight, rightTakeoff, leftTakeoff));
+        _mm_storeu_ps(&velocityX[i], blend(useRight, _mm_sub_ps(zero, speed), speed));
+        _mm_storeu_ps(&time[i], blend(reachable, downTime, none));
+    }
+
+    // Leftover targets
+    Launch launch;
+    for (; i < targets.count; i++)
+    {
+        const Segment to = { targets.y[i], Range(targets.minX[i], targets.maxX[i]) };
+        if (solveJump(from, to, launch))
+        {
+            takeoffX[i] = launch.takeoffX;
+            velocityX[i] = launch.velocity.x;
+            time[i] = launch.time;
+        }
+        else
+        {
+            takeoffX[i] = 0.0f;
+            velocityX[i] = 0.0f;
+            time[i] = -1.0f;
+        }
+    }
+}
+
+void JumpSolver::solveDrops(const Segment& from, float side, const Segments& targets, float* time) const
+{
+    const float takeoffX = getDropTakeoffX(from, side);
+    const bool gravityValid = settings.gravity > 0.0f;
+
+    const __m128 fromY = _mm_set1_ps(from.y);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 invGravity = _mm_set1_ps(inverseGravity);
+    const __m128 overlap = _mm_set1_ps(landingOverlap);
+    const __m128 takeoff = _mm_set1_ps(takeoffX);
+    const __m128 velocity = _mm_set1_ps(side * settings.maxSpeed);
+    const __m128 halfWidth = _mm_set1_ps(settings.bodySize.x * 0.5f);
+    const __m128 epsilon = _mm_set1_ps(SAME_LINE_EPSILON);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 none = _mm_set1_ps(-1.0f);
+    const __m128 gravityMask = gravityValid ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+
+    size_t i = 0;
+    for (; i + 4 <= targets.count; i += 4)
+    {
+        const __m128 toY = _mm_loadu_ps(&targets.y[i]);
+        const __m128 toMin = _mm_loadu_ps(&targets.minX[i]);
+        const __m128 toMax = _mm_loadu_ps(&targets.maxX[i]);
+
+        const __m128 height = _mm_sub_ps(fromY, toY);
+        const __m128 valid = _mm_and_ps(gravityMask, _mm_cmpgt_ps(height, epsilon));
+
+        const __m128 fallTime = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(_mm_mul_ps(two, height), invGravity), zero));
+        const __m128 landing = _mm_add_ps(takeoff, _mm_mul_ps(velocity, fallTime));
+        const __m128 hit = _mm_and_ps(valid, _mm_and_ps(
+            _mm_cmplt_ps(_mm_sub_ps(landing, halfWidth), _mm_sub_ps(toMax, overlap)),
+            _mm_cmpgt_ps(_mm_add_ps(landing, halfWidth), _mm_add_ps(toMin, overlap))));
+
+        _mm_storeu_ps(&time[i], blend(hit, fallTime, none));
+    }
+
+    // Leftover targets
+    Launch launch;
+    for (; i < targets.count; i++)
+    {
+        const Segment to = { targets.y[i], Range(targets.minX[i], targets.maxX[i]) };
+        time[i] = solveDrop(from, side, to, launch) ? launch.time : -1.0f;
+    }
+}
+
+float JumpSolver::getDropTakeoffX(const Segment& from, float side) const
+{
+    const float halfWidth = settings.bodySize.x * 0.5f;
+    return side > 0.0f ? from.x.max + halfWidth : from.x.min - halfWidth;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Core/Range.h"
+#include "Core/Vec2.h"
+
+#include <cstddef>
+
+// Closed form ballistics of a body moving like Character::update, between two horizontal segments
+// Jumps start at maxJumpVelocity and full speed from beside the higher segment, so the head passes
+// its side before the feet come down on it. Drops walk off one end at full speed.
+// Side walls and ceilings met mid-air are not checked.
+class JumpSolver
+{
+public:
+    struct Settings
+    {
+        float maxSpeed = 0.0f;
+        float maxJumpVelocity = 0.0f;
+        float gravity = 0.0f; // Downwards acceleration, positive
+        Vec2 bodySize;
+        float stepTime = 1.0f / 60.0f; // Time of one character update, stepped jumps peak a bit lower than the smooth arc
+    };
+
+    struct Segment
+    {
+        float y;
+        Range x;
+    };
+
+    // Target segments as separate arrays, for batches
+    struct Segments
+    {
+        const float* y;
+        const float* minX;
+        const float* maxX;
+        size_t count;
+    };
+
+    struct Launch
+    {
+        float takeoffX;  // Body center when it leaves the segment
+        Vec2 velocity;   // Zero vertical velocity for drops
+        float time;      // From takeoff to landing
+    };
+
+    JumpSolver() = default;
+    explicit JumpSolver(const Settings& newSettings);
+
+    void setSettings(const Settings& newSettings);
+    const Settings& getSettings() const;
+
+    // Jump from one segment onto a higher one, cheapest of both approach sides
+    // Cost is flight time plus walking from the middle of from to takeoff
+    bool solveJump(const Segment& from, const Segment& to, Launch& launch) const;
+
+    // Walk off the left (side -1) or right (side 1) end of from and land on a lower segment
+    bool solveDrop(const Segment& from, float side, const Segment& to, Launch& launch) const;
+
+    // Same as above for many targets, four at a time with SSE
+    // Outputs have targets.count entries, time is negative where target can't be reached
+    void solveJumps(const Segment& from, const Segments& targets, float* takeoffX, float* velocityX, float* time) const;
+    void solveDrops(const Segment& from, float side, const Segments& targets, float* time) const;
+
+    // Center x a body leaves from when walking off given side
+    float getDropTakeoffX(const Segment& from, float side) const;
+private:
+    Settings settings;
+
+    // Derived from settings
+    float arcVelocity = 0.0f; // Launch velocity of the smooth arc matching stepped one
+    float inverseGravity = 0.0f;
+    float inverseSpeed = 0.0f;
+    float landingOverlap = 0.0f; // Body must land this far over the target
+};
@@ -0,0 +1,508 @@
+#include "NavigationGraph.h"
+
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+const uint32_t NavigationGraph::NONE;
+
+// Feet closer to a platform line than this stand on it
+static const float STANDING_EPSILON = 1e-3f;
+
+static bool platformLess(const NavigationGraph::Platform& a, const NavigationGraph::Platform& b)
+{
+    if (a.y != b.y)
+    {
+        return a.y < b.y;
+    }
+    return a.x.min < b.x.min;
+}
+
+static bool platformEqual(const NavigationGraph::Platform& a, const NavigationGraph::Platform& b)
+{
+    return a.y == b.y && a.x.min == b.x.min && a.x.max == b.x.max;
+}
+
+// Bottom edges of windows are platforms too, characters land on them from inside the window
+static bool isOnWindowTop(const WorldSnapshot& world, float y, const Range& x)
+{
+    auto it = std::lower_bound(world.windowTops.begin(), world.windowTops.end(), y - STANDING_EPSILON,
+        [](const Obstacle& top, float value) { return top.perpOffset < value; });
+    for (; it != world.windowTops.end() && it->perpOffset <= y + STANDING_EPSILON; it++)
+    {
+        size_t segmentIndex = 0;
+        if (it->segments.findOverlap(x.min, x.max, segmentIndex))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NavigationGraph::fitCharacter(const Vec2& size, const Character::Data& data, float stepTime)
+{
+    JumpSolver::Settings settings = solver.getSettings();
+    if (!fitted)
+    {
+        settings.maxSpeed = data.maxSpeed;
+        settings.maxJumpVelocity = data.maxJumpVelocity;
+        settings.bodySize = size;
+        settings.stepTime = stepTime;
+    }
+    else
+    {
+        settings.maxSpeed = std::min(settings.maxSpeed, data.maxSpeed);
+        settings.maxJumpVelocity = std::min(settings.maxJumpVelocity, data.maxJumpVelocity);
+        settings.bodySize = Vec2(std::max(settings.bodySize.x, size.x), std::max(settings.bodySize.y, size.y));
+        settings.stepTime = std::max(settings.stepTime, stepTime);
+    }
+    settings.gravity = -Character::gravity.y;
+    solver.setSettings(settings);
+
+    fitted = true;
+    fullRebuild = true;
+    worldVersion = UINT64_MAX;
+}
+
+void NavigationGraph::update(const WorldSnapshot& world)
+{
+    if (world.version == worldVersion)
+    {
+        return;
+    }
+    worldVersion = world.version;
+
+    PROFILE_FUNCTION();
+
+    // Every horizontal segment except the world top is something to stand on
+    newPlatforms.clear();
+    for (size_t i = 0; i < world.verticalBegin; i++)
+    {
+        const Obstacle& obstacle = world.obstacles[i];
+        if (obstacle.perpOffset >= world.bounds.maxY)
+        {
+            continue;
+        }
+
+        for (const Range& segment : obstacle.segments)
+        {
+            Platform platform;
+            platform.y = obstacle.perpOffset;
+            platform.x = segment;
+            platform.windowTop = isOnWindowTop(world, platform.y, segment);
+            newPlatforms.push_back(std::move(platform));
+        }
+    }
+    std::sort(newPlatforms.begin(), newPlatforms.end(), platformLess);
+
+    // Unchanged platforms keep their edges, both lists are sorted the same way
+    remap.assign(platforms.size(), NONE);
+    dirty.assign(newPlatforms.size(), true);
+    for (size_t i = 0, j = 0; i < platforms.size() && j < newPlatforms.size();)
+    {
+        if (platformEqual(platforms[i], newPlatforms[j]))
+        {
+            remap[i] = (uint32_t)j;
+            newPlatforms[j].edges = std::move(platforms[i].edges);
+            dirty[j] = false;
+            i++;
+            j++;
+        }
+        else if (platformLess(platforms[i], newPlatforms[j]))
+        {
+            i++;
+        }
+        else
+        {
+            j++;
+        }
+    }
+
+    added.clear();
+    for (size_t j = 0; j < newPlatforms.size(); j++)
+    {
+        if (dirty[j])
+        {
+            added.push_back((uint32_t)j);
+        }
+    }
+
+    const bool changed = fullRebuild || !added.empty() || newPlatforms.size() != platforms.size();
+
+    // Kept platforms are rebuilt if they led to a removed platform or may lead to an added one
+    Edge edge;
+    for (size_t j = 0; j < newPlatforms.size(); j++)
+    {
+        if (dirty[j])
+        {
+            continue;
+        }
+
+        Platform& platform = newPlatforms[j];
+        bool rebuild = fullRebuild;
+        for (Edge& kept : platform.edges)
+        {
+            kept.to = remap[kept.to];
+            rebuild |= kept.to == NONE;
+        }
+
+        for (size_t k = 0; k < added.size() && !rebuild; k++)
+        {
+            const Platform& other = newPlatforms[added[k]];
+            rebuild = walkEdge(platform, other, edge) || mayReach(platform, other);
+        }
+        dirty[j] = rebuild;
+    }
+
+    platforms.swap(newPlatforms);
+    fullRebuild = false;
+
+    platformsY.resize(platforms.size());
+    platformsMinX.resize(platforms.size());
+    platformsMaxX.resize(platforms.size());
+    for (size_t i = 0; i < platforms.size(); i++)
+    {
+        platformsY[i] = platforms[i].y;
+        platformsMinX[i] = platforms[i].x.min;
+        platformsMaxX[i] = platforms[i].x.max;
+    }
+
+    edgesCount = 0;
+    for (size_t i = 0; i < platforms.size(); i++)
+    {
+        if (dirty[i])
+        {
+            buildEdges((uint32_t)i);
+            rebuiltPlatformsCount++;
+        }
+        edgesCount += platforms[i].edges.size();
+    }
+
+    // Cached routes point at old indices
+    if (changed || std::find(dirty.begin(), dirty.end(), true) != dirty.end())
+    {
+        routes.clear();
+        targetRoute = nullptr;
+        targetPlatform = NONE;
+    }
+}
+
+void NavigationGraph::setTarget(const Vec2& newTarget)
+{
+    target = newTarget;
+
+    const uint32_t platform = findPlatformBelow(target);
+    if (platform == targetPlatform && (targetRoute || platform == NONE))
+    {
+        return;
+    }
+
+    targetPlatform = platform;
+    targetRoute = platform == NONE ? nullptr : &getRoute(platform);
+}
+
+bool NavigationGraph::getWaypoint(const Character& character, Waypoint& waypoint) const
+{
+    if (!targetRoute)
+    {
+        return false;
+    }
+
+    const AABB& aabb = character.getAABB();
+    const uint32_t current = findPlatform(aabb.minY, aabb.minX, aabb.maxX);
+    if (current == NONE)
+    {
+        return false;
+    }
+
+    const Platform& platform = platforms[current];
+    waypoint = Waypoint();
+    if (current == targetPlatform)
+    {
+        waypoint.position = target;
+        return true;
+    }
+
+    const uint32_t edgeIndex = targetRoute->nextEdge[current];
+    if (edgeIndex == NONE)
+    {
+        return false;
+    }
+
+    const Edge& edge = platform.edges[edgeIndex];
+    waypoint.position = Vec2(edge.takeoffX, platform.y);
+    switch (edge.type)
+    {
+    case EdgeType::Walk:
+        break;
+    case EdgeType::Jump:
+        waypoint.jump = true;
+        waypoint.jumpVelocity = Vec2(edge.velocityX, edge.velocityY);
+        break;
+    case EdgeType::Drop:
+        // Aim past the edge, so the character is still at full speed when it leaves
+        waypoint.position.x += copysignf(solver.getSettings().bodySize.x * 0.5f, edge.velocityX);
+        break;
+    }
+    return true;
+}
+
+const NavigationGraph::Platform* NavigationGraph::getStandingPlatform(const Character& character) const
+{
+    const AABB& aabb = character.getAABB();
+    const uint32_t index = findPlatform(aabb.minY, aabb.minX, aabb.maxX);
+    return index != NONE ? &platforms[index] : nullptr;
+}
+
+const std::vector<NavigationGraph::Platform>& NavigationGraph::getPlatforms() const
+{
+    return platforms;
+}
+
+size_t NavigationGraph::getEdgesCount() const
+{
+    return edgesCount;
+}
+
+uint64_t NavigationGraph::getRebuiltPlatformsCount() const
+{
+    return rebuiltPlatformsCount;
+}
+
+// Platform at feet height overlapping (minX, maxX), the one closest to the center if several do
+uint32_t NavigationGraph::findPlatform(float y, float minX, float maxX) const
+{
+    auto it = std::lower_bound(platforms.begin(), platforms.end(), y - STANDING_EPSILON,
+        [](const Platform& platform, float value) { return platform.y < value; });
+
+    const float centerX = (minX + maxX) * 0.5f;
+    uint32_t best = NONE;
+    float bestDistance = FLT_MAX;
+    for (; it != platforms.end() && it->y <= y + STANDING_EPSILON; it++)
+    {
+        if (it->x.max <= minX || it->x.min >= maxX)
+        {
+            continue;
+        }
+
+        const float distance = std::max(0.0f, std::max(it->x.min - centerX, centerX - it->x.max));
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = (uint32_t)(it - platforms.begin());
+        }
+    }
+    return best;
+}
+
+// Highest platform a character standing right under point would be on
+uint32_t NavigationGraph::findPlatformBelow(const Vec2& point) const
+{
+    const float halfWidth = solver.getSettings().bodySize.x * 0.5f;
+
+    auto it = std::upper_bound(platforms.begin(), platforms.end(), point.y,
+        [](float value, const Platform& platform) { return value < platform.y; });
+    while (it != platforms.begin())
+    {
+        it--;
+        if (it->x.min - halfWidth < point.x && point.x < it->x.max + halfWidth)
+        {
+            return (uint32_t)(it - platforms.begin());
+        }
+    }
+    return NONE;
+}
+
+void NavigationGraph::buildEdges(uint32_t index)
+{
+    Platform& platform = platforms[index];
+    platform.edges.clear();
+
+    // Jumps and drops against every platform at once
+    const JumpSolver::Segment from = { platform.y, platform.x };
+    const JumpSolver::Segments targets = { platformsY.data(), platformsMinX.data(), platformsMaxX.data(), platforms.size() };
+
+    jumpTakeoffX.resize(targets.count);
+    jumpVelocityX.resize(targets.count);
+    jumpTime.resize(targets.count);
+    solver.solveJumps(from, targets, jumpTakeoffX.data(), jumpVelocityX.data(), jumpTime.data());
+    for (int side = 0; side < 2; side++)
+    {
+        dropTime[side].resize(targets.count);
+        solver.solveDrops(from, side ? 1.0f : -1.0f, targets, dropTime[side].data());
+    }
+
+    // Walking off a side only drops if no neighbour is close enough to walk onto
+    bool walkable[2] = { false, false };
+    uint32_t dropTo[2] = { NONE, NONE };
+
+    Edge edge;
+    for (uint32_t i = 0; i < (uint32_t)platforms.size(); i++)
+    {
+        if (i == index)
+        {
+            continue;
+        }
+
+        if (walkEdge(platform, platforms[i], edge))
+        {
+            edge.to = i;
+            platform.edges.push_back(edge);
+            walkable[edge.velocityX > 0.0f] = true;
+        }
+        else if (jumpTime[i] >= 0.0f)
+        {
+            edge = { i, EdgeType::Jump, jumpTakeoffX[i], jumpVelocityX[i], solver.getSettings().maxJumpVelocity, jumpTime[i] + getWalkTime(platform, jumpTakeoffX[i]) };
+            platform.edges.push_back(edge);
+        }
+
+        // Character falls onto the highest platform under its path
+        for (int side = 0; side < 2; side++)
+        {
+            if (dropTime[side][i] >= 0.0f && (dropTo[side] == NONE || platforms[dropTo[side]].y < platforms[i].y))
+            {
+                dropTo[side] = i;
+            }
+        }
+    }
+
+    const float speed = solver.getSettings().maxSpeed;
+    for (int side = 0; side < 2; side++)
+    {
+        if (dropTo[side] != NONE && !walkable[side])
+        {
+            const float sideSign = side ? 1.0f : -1.0f;
+            const float takeoffX = solver.getDropTakeoffX(from, sideSign);
+            edge = { dropTo[side], EdgeType::Drop, takeoffX, sideSign * speed, 0.0f, dropTime[side][dropTo[side]] + getWalkTime(platform, takeoffX) };
+            platform.edges.push_back(edge);
+        }
+    }
+}
+
+// Next edge towards platform to from every other platform, cheapest first
+const NavigationGraph::Route& NavigationGraph::getRoute(uint32_t to)
+{
+    auto it = routes.find(to);
+    if (it != routes.end())
+    {
+        return it->second;
+    }
+
+    PROFILE_FUNCTION();
+
+    if (routes.size() >= MAX_CACHED_ROUTES)
+    {
+        routes.clear();
+    }
+
+    const size_t count = platforms.size();
+    Route& route = routes[to];
+    route.nextEdge.assign(count, NONE);
+
+    // Edges grouped by the platform they lead to
+    std::vector<uint32_t> incomingBegin(count + 1, 0);
+    for (const Platform& platform : platforms)
+    {
+        for (const Edge& edge : platform.edges)
+        {
+            incomingBegin[edge.to + 1]++;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        incomingBegin[i + 1] += incomingBegin[i];
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> incoming(edgesCount); // Source platform, edge index in it
+    std::vector<uint32_t> fill(incomingBegin.begin(), incomingBegin.end() - 1);
+    for (uint32_t from = 0; from < (uint32_t)count; from++)
+    {
+        const std::vector<Edge>& edges = platforms[from].edges;
+        for (uint32_t e = 0; e < (uint32_t)edges.size(); e++)
+        {
+            incoming[fill[edges[e].to]++] = std::make_pair(from, e);
+        }
+    }
+
+    // Dijkstra backwards from target
+    typedef std::pair<float, uint32_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    std::vector<float> cost(count, FLT_MAX);
+
+    cost[to] = 0.0f;
+    queue.push(Entry(0.0f, to));
+    while (!queue.empty())
+    {
+        const Entry entry = queue.top();
+        queue.pop();
+        if (entry.first > cost[entry.second])
+        {
+            continue;
+        }
+
+        for (uint32_t i = incomingBegin[entry.second]; i < incomingBegin[entry.second + 1]; i++)
+        {
+            const uint32_t from = incoming[i].first;
+            const Edge& edge = platforms[from].edges[incoming[i].second];
+            const float newCost = entry.first + edge.cost;
+            if (newCost < cost[from])
+            {
+                cost[from] = newCost;
+                route.nextEdge[from] = incoming[i].second;
+                queue.push(Entry(newCost, from));
+            }
+        }
+    }
+
+    return route;
+}
+
+// Neighbour on the same line, with a gap the character's body spans
+bool NavigationGraph::walkEdge(const Platform& from, const Platform& to, Edge& edge) const
+{
+    if (fabsf(to.y - from.y) > STANDING_EPSILON)
+    {
+        return false;
+    }
+
+    const float width = solver.getSettings().bodySize.x;
+    const float inset = std::min(width * 0.5f, (to.x.max - to.x.min) * 0.5f);
+    if (to.x.min >= from.x.max && to.x.min - from.x.max < width)
+    {
+        edge = { 0, EdgeType::Walk, to.x.min + inset, 1.0f, 0.0f, 0.0f };
+    }
+    else if (from.x.min >= to.x.max && from.x.min - to.x.max < width)
+    {
+        edge = { 0, EdgeType::Walk, to.x.max - inset, -1.0f, 0.0f, 0.0f };
+    }
+    else
+    {
+        return false;
+    }
+
+    edge.cost = getWalkTime(from, edge.takeoffX);
+    return true;
+}
+
+// Jump or drop onto to exists, ignoring every other platform
+bool NavigationGraph::mayReach(const Platform& from, const Platform& to) const
+{
+    const JumpSolver::Segment fromSegment = { from.y, from.x };
+    const JumpSolver::Segment toSegment = { to.y, to.x };
+
+    JumpSolver::Launch launch;
+    return solver.solveJump(fromSegment, toSegment, launch) ||
+        solver.solveDrop(fromSegment, -1.0f, toSegment, launch) ||
+        solver.solveDrop(fromSegment, 1.0f, toSegment, launch);
+}
+
+// From the middle of the platform, entry point is not tracked
+float NavigationGraph::getWalkTime(const Platform& from, float x) const
+{
+    return fabsf(x - (from.x.min + from.x.max) * 0.5f) / std::max(solver.getSettings().maxSpeed, FLT_EPSILON);
+}
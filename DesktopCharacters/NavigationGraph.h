@@ -0,0 +1,112 @@
+#pragma once
+#include "Core/Range.h"
+#include "Core/Vec2.h"
+
+#include "Character.h"
+#include "JumpSolver.h"
+#include "WorldSnapshot.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Platforms characters can stand on, linked by walk, jump and drop edges
+// Nodes are horizontal obstacle segments, jump and drop edges come from JumpSolver.
+// Routes are cached per target platform, every follower standing anywhere shares one table.
+class NavigationGraph
+{
+public:
+    enum class EdgeType : char { Walk, Jump, Drop };
+
+    struct Edge
+    {
+        uint32_t to;
+        EdgeType type;
+        float takeoffX;  // Center x where the character leaves its platform, for walks a point on the next one
+        float velocityX; // Horizontal velocity while airborne, for walks only its sign matters
+        float velocityY; // Vertical launch velocity of jumps, edges are solved with it
+        float cost;      // Seconds, rough
+    };
+
+    struct Platform
+    {
+        float y;
+        Range x;
+        bool windowTop = false; // Lies on a window's top edge, not on its bottom or the floor
+        std::vector<Edge> edges;
+    };
+
+    // Where a follower should go next
+    struct Waypoint
+    {
+        Vec2 position;
+        bool jump = false;
+        Vec2 jumpVelocity;
+    };
+
+    // Widens settings so that every added character can follow built edges
+    // stepTime is the longest update character may get, arcs are solved for it
+    // Forces a full rebuild
+    void fitCharacter(const Vec2& size, const Character::Data& data, float stepTime);
+
+    // Rebuilds edges of platforms near changed ones, does nothing if world version is unchanged
+    void update(const WorldSnapshot& world);
+
+    // Picks target region, routes to it are computed once and shared
+    // Called before followers query, may allocate
+    void setTarget(const Vec2& target);
+
+    // False if character is not standing on a known platform or the target is unreachable,
+    // followers then head straight for the target
+    bool getWaypoint(const Character& character, Waypoint& waypoint) const;
+
+    // Platform under character's feet, nullptr if airborne or on something else
+    const Platform* getStandingPlatform(const Character& character) const;
+
+    const std::vector<Platform>& getPlatforms() const;
+    size_t getEdgesCount() const;
+    uint64_t getRebuiltPlatformsCount() const;
+private:
+    static const size_t MAX_CACHED_ROUTES = 16;
+    static const uint32_t NONE = UINT32_MAX;
+
+    // Next edge from every platform towards one target platform
+    struct Route
+    {
+        std::vector<uint32_t> nextEdge; // Index into platform's edges, NONE if unreachable
+    };
+
+    JumpSolver solver; // Set up for the most limited character
+    bool fitted = false; // Any character was fitted
+    bool fullRebuild = true; // Settings changed, no edge can be kept
+    uint64_t worldVersion = UINT64_MAX;
+
+    std::vector<Platform> platforms; // Sorted by y, then by x
+    std::vector<float> platformsY, platformsMinX, platformsMaxX; // Same platforms as separate arrays, for solver batches
+    size_t edgesCount = 0;
+    uint64_t rebuiltPlatformsCount = 0;
+
+    std::unordered_map<uint32_t, Route> routes; // By target platform, cleared when edges change
+    Vec2 target;
+    uint32_t targetPlatform = NONE;
+    const Route* targetRoute = nullptr;
+
+    // Scratch for update(), reused between rebuilds
+    std::vector<Platform> newPlatforms;
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> added;
+    std::vector<bool> dirty;
+    std::vector<float> jumpTakeoffX, jumpVelocityX, jumpTime, dropTime[2];
+
+    uint32_t findPlatform(float y, float minX, float maxX) const;
+    uint32_t findPlatformBelow(const Vec2& point) const;
+
+    void buildEdges(uint32_t index);
+    const Route& getRoute(uint32_t to);
+
+    // Single edge candidates, ignoring every other platform
+    bool walkEdge(const Platform& from, const Platform& to, Edge& edge) const;
+    bool mayReach(const Platform& from, const Platform& to) const;
+
+    float getWalkTime(const Platform& from, float x) const;
+};
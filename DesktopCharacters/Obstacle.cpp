@@ -1,18 +1,19 @@
 #include "Obstacle.h"
 
+#include <algorithm>
+
 Obstacle::Obstacle() :
     type(Type::Horizontal)
 {
 }
 
 Obstacle::Obstacle(Type type, float perpOffset, float minX, float maxX) :
-    type(type), perpOffset(perpOffset)
+    type(type), perpOffset(perpOffset), segments(Range(minX, maxX))
 {
-    segments.emplace_back(minX, maxX);
 }
 
 Obstacle::Obstacle(Obstacle&& other) noexcept :
-    type(other.type), perpOffset(other.perpOffset), segments(std::move(other.segments))
+    type(other.type), perpOffset(other.perpOffset), segments(std::move(other.segments)), motions(std::move(other.motions))
 {
 }
 
@@ -23,6 +24,79 @@ Obstacle& Obstacle::operator=(Obstacle&& other) noexcept
         type = other.type;
         perpOffset = other.perpOffset;
         segments = std::move(other.segments);
+        motions = std::move(other.motions);
     }
     return *this;
-}
\ No newline at end of file
+}
+
+void Obstacle::setVelocity(const Vec2& velocity)
+{
+    motions.clear();
+    if (segments.empty())
+    {
+        return;
+    }
+
+    // Segments are sorted
+    Range span(segments.front().min, segments.back().max);
+    motions.push_back({ span, velocity });
+}
+
+Vec2 Obstacle::getVelocityAt(float coordinate) const
+{
+    for (const auto& motion : motions)
+    {
+        if (motion.span.min <= coordinate && coordinate <= motion.span.max)
+        {
+            return motion.velocity;
+        }
+    }
+    return Vec2();
+}
+
+void Obstacle::coalesce(std::vector<Obstacle>& obstacles, float epsilon)
+{
+    if (obstacles.size() < 2)
+    {
+        return;
+    }
+
+    std::sort(obstacles.begin(), obstacles.end(), [](const Obstacle& a, const Obstacle& b)
+        {
+            if (a.type != b.type)
+            {
+                return a.type < b.type;
+            }
+            return a.perpOffset < b.perpOffset;
+        });
+
+    // Join lines into first obstacle of their group, emptied ones are dropped below
+    size_t groupStart = 0;
+    for (size_t i = 1; i < obstacles.size(); i++)
+    {
+        Obstacle& group = obstacles[groupStart];
+        Obstacle& current = obstacles[i];
+
+        if (current.type == group.type && current.perpOffset - group.perpOffset <= epsilon)
+        {
+            for (const Range& segment : current.segments)
+            {
+                group.segments.insert(segment);
+            }
+            group.motions.insert(group.motions.end(), current.motions.begin(), current.motions.end());
+            current.segments.clear();
+            continue;
+        }
+
+        groupStart = i;
+    }
+
+    obstacles.erase(std::remove_if(obstacles.begin(), obstacles.end(),
+        [](const Obstacle& obstacle) { return obstacle.segments.empty(); }), obstacles.end());
+
+    // Segments of neighbouring windows that nearly touch become one
+    for (Obstacle& obstacle : obstacles)
+    {
+        obstacle.segments.closeGaps(epsilon);
+    }
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "Core/IntervalSet.h"
 #include "Core/Range.h"
 #include "Core/Vec2.h"
 
@@ -15,10 +16,17 @@ struct Obstacle
         Range segment;
     };*/
 
+    // Velocity of an edge this obstacle was built from, over its span along the obstacle
+    struct Motion
+    {
+        Range span;
+        Vec2 velocity;
+    };
+
     Type type;
     float perpOffset = 0.0f;
-    std::vector<Range> segments;
-    Vec2 velocity = { 0.0f, 0.0f };
+    IntervalSet segments;
+    std::vector<Motion> motions;
 
     Obstacle();
     Obstacle(Type type, float perpOffset, float minX, float maxX);
@@ -28,4 +36,14 @@ struct Obstacle
 
     Obstacle(Obstacle&& other) noexcept;
     Obstacle& operator=(Obstacle&& other) noexcept;
-};
\ No newline at end of file
+
+    // Same velocity for the whole obstacle
+    void setVelocity(const Vec2& velocity);
+
+    // Velocity of the edge covering coordinate along the obstacle, zero if none does
+    Vec2 getVelocityAt(float coordinate) const;
+
+    // Merges obstacles of the same type lying on the same line (within epsilon) into one,
+    // touching or overlapping segments are joined. Motions are kept.
+    static void coalesce(std::vector<Obstacle>& obstacles, float epsilon);
+};
@@ -9,3 +9,33 @@ WindowData::WindowData(size_t id, std::wstring&& title, std::wstring&& className
 	id(id), title(std::move(title)), className(std::move(className)), x(x), y(y), w(w), h(h), zOrder(zOrder)
 {
 }
+
+
+uint64_t BasePlatformInterface::getTimeNanoseconds() const
+{
+	if (fakeClockEnabled.load(std::memory_order_relaxed))
+	{
+		return fakeClockTime.load(std::memory_order_relaxed);
+	}
+	return getMonotonicTimeNanoseconds();
+}
+
+double BasePlatformInterface::getTimeSeconds() const
+{
+	return (double)getTimeNanoseconds() * 1e-9;
+}
+
+void BasePlatformInterface::setFakeClockEnabled(bool enabled)
+{
+	// Continue from current real time, so deltas stay sane when switching
+	if (enabled && !fakeClockEnabled)
+	{
+		fakeClockTime = getMonotonicTimeNanoseconds();
+	}
+	fakeClockEnabled = enabled;
+}
+
+void BasePlatformInterface::advanceFakeClock(uint64_t nanoseconds)
+{
+	fakeClockTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
@@ -1,3 +1,6 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -34,4 +37,18 @@ public:
     virtual void getScreenResolution(int& w, int& h) const = 0;
     
     virtual void getWindows(std::vector<WindowData>& result) const = 0;
+
+    // Monotonic clock, only differences between values are meaningful
+    // Returns fake clock time while fake clock is enabled
+    uint64_t getTimeNanoseconds() const;
+    double getTimeSeconds() const;
+
+    // Fake clock for fixed step replay, time moves only when advanced
+    void setFakeClockEnabled(bool enabled);
+    void advanceFakeClock(uint64_t nanoseconds);
+protected:
+    virtual uint64_t getMonotonicTimeNanoseconds() const = 0;
+private:
+    std::atomic<bool> fakeClockEnabled{ false };
+    std::atomic<uint64_t> fakeClockTime{ 0 };
 };
\ No newline at end of file
@@ -0,0 +1,1081 @@
+#include "InputCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const char MAGIC[4] = { 'D', 'C', 'I', 'C' };
+    const char INDEX_MAGIC[4] = { 'D', 'C', 'I', 'X' };
+    const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        int32_t screenWidth;
+        int32_t screenHeight;
+    };
+
+    // Index record offset and INDEX_MAGIC, last bytes of a closed capture
+    const uint64_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(INDEX_MAGIC);
+
+    // Record is a type byte, varint payload size and payload
+    enum RecordType : uint8_t
+    {
+        RECORD_KEYFRAME = 1, // Decoder state is reset first
+        RECORD_DELTA = 2,
+        RECORD_INDEX = 3
+    };
+
+    // Frame payload is a varint time difference in microseconds, these flags, then flagged parts in this order
+    enum FrameFlags : uint8_t
+    {
+        FRAME_MOUSE_MOVED = 1,
+        FRAME_MOUSE_BUTTONS = 2,
+        FRAME_WINDOWS = 4,
+        FRAME_EVENT = 8
+    };
+
+    // Window list is a varint count followed by ops, each a varint with op in low two bits.
+    // Previous windows that no op refers to were closed.
+    enum WindowOp : uint8_t
+    {
+        OP_COPY = 0,    // Run of unchanged windows continuing in previous list, length in high bits
+        OP_CHANGED = 1, // Previous window at skew from continuing position in high bits, field mask and changed fields
+        OP_ADDED = 2    // New window, id and every field
+    };
+
+    enum WindowField : uint8_t
+    {
+        FIELD_X = 1,
+        FIELD_Y = 2,
+        FIELD_W = 4,
+        FIELD_H = 8,
+        FIELD_Z_ORDER = 16,
+        FIELD_TITLE = 32,
+        FIELD_CLASS_NAME = 64
+    };
+
+    uint64_t zigzag(int64_t value)
+    {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value)
+    {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    void putVarint(std::vector<uint8_t>& buffer, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((uint8_t)value);
+    }
+
+    void putSigned(std::vector<uint8_t>& buffer, int64_t value)
+    {
+        putVarint(buffer, zigzag(value));
+    }
+}
+
+struct InputCaptureReader::Decoder
+{
+    const uint8_t* data;
+    const uint8_t* end;
+
+    explicit Decoder(const std::vector<uint8_t>& buffer) : data(buffer.data()), end(buffer.data() + buffer.size()) {}
+
+    bool varint(uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (data == end)
+            {
+                return false;
+            }
+
+            const uint8_t byte = *data++;
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool signedVarint(int64_t& value)
+    {
+        uint64_t encoded = 0;
+        if (!varint(encoded))
+        {
+            return false;
+        }
+        value = unzigzag(encoded);
+        return true;
+    }
+
+    bool byte(uint8_t& value)
+    {
+        if (data == end)
+        {
+            return false;
+        }
+        value = *data++;
+        return true;
+    }
+
+    size_t remaining() const { return (size_t)(end - data); }
+};
+
+
+InputCaptureWriter::~InputCaptureWriter()
+{
+    close();
+}
+
+bool InputCaptureWriter::open(const std::string& path, int screenWidth, int screenHeight)
+{
+    close();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to open input capture file: " << path << std::endl;
+        return false;
+    }
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.screenWidth = screenWidth;
+    header.screenHeight = screenHeight;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fileSize = sizeof(header);
+    bytesWritten = fileSize;
+    droppedChunks = 0;
+    keyframes.clear();
+
+    started = false;
+    lastTime = 0;
+    keyframeDue = true;
+    mouse = InputMouseState();
+    windows.clear();
+
+    stopping = false;
+    writingPaused = false;
+    thread = std::thread(&InputCaptureWriter::writeLoop, this);
+
+    opened = true;
+    return true;
+}
+
+bool InputCaptureWriter::isOpen() const
+{
+    return opened;
+}
+
+void InputCaptureWriter::close()
+{
+    if (!opened)
+    {
+        return;
+    }
+    opened = false;
+    setWritingPaused(false);
+
+    // Last chunk is never dropped
+    flushChunk(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    thread.join();
+
+    // Keyframe index lets replay seek without scanning the whole file
+    payload.clear();
+    putVarint(payload, keyframes.size());
+    uint64_t previousTime = 0;
+    uint64_t previousOffset = 0;
+    for (const InputKeyframe& keyframe : keyframes)
+    {
+        const uint64_t time = keyframe.time / 1000;
+        putVarint(payload, time - previousTime);
+        putVarint(payload, keyframe.offset - previousOffset);
+        previousTime = time;
+        previousOffset = keyframe.offset;
+    }
+
+    std::vector<uint8_t> record;
+    record.push_back(RECORD_INDEX);
+    putVarint(record, payload.size());
+    record.insert(record.end(), payload.begin(), payload.end());
+
+    const uint64_t indexOffset = fileSize;
+    file.write(reinterpret_cast<const char*>(record.data()), record.size());
+    file.write(reinterpret_cast<const char*>(&indexOffset), sizeof(indexOffset));
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    file.close();
+
+    bytesWritten += record.size() + TRAILER_SIZE;
+
+    if (droppedChunks > 0)
+    {
+        std::cout << "Input capture dropped " << droppedChunks << " chunks, disk couldn't keep up" << std::endl;
+    }
+}
+
+void InputCaptureWriter::writeMouse(uint64_t time, const InputMouseState& newMouse)
+{
+    if (!opened || newMouse == mouse)
+    {
+        return;
+    }
+
+    const uint64_t frameTime = beginFrame(time);
+
+    uint8_t flags = 0;
+    if (newMouse.x != mouse.x || newMouse.y != mouse.y)
+    {
+        flags |= FRAME_MOUSE_MOVED;
+    }
+    if (newMouse.buttons != mouse.buttons)
+    {
+        flags |= FRAME_MOUSE_BUTTONS;
+    }
+
+    payload.clear();
+    putVarint(payload, frameTime - lastTime);
+    payload.push_back(flags);
+    if (flags & FRAME_MOUSE_MOVED)
+    {
+        putSigned(payload, (int64_t)newMouse.x - mouse.x);
+        putSigned(payload, (int64_t)newMouse.y - mouse.y);
+    }
+    if (flags & FRAME_MOUSE_BUTTONS)
+    {
+        payload.push_back(newMouse.buttons);
+    }
+
+    mouse = newMouse;
+    lastTime = frameTime;
+    writeRecord(RECORD_DELTA);
+}
+
+void InputCaptureWriter::writeWindows(uint64_t time, const std::vector<WindowData>& newWindows)
+{
+    if (!opened)
+    {
+        return;
+    }
+
+    const uint64_t frameTime = beginFrame(time);
+
+    payload.clear();
+    putVarint(payload, frameTime - lastTime);
+    payload.push_back(FRAME_WINDOWS);
+    encodeWindows(newWindows, windows);
+
+    // Element-wise copy, strings keep their buffers
+    windows = newWindows;
+    lastTime = frameTime;
+    writeRecord(RECORD_DELTA);
+}
+
+void InputCaptureWriter::writeEvent(uint64_t time, const InputEvent& event)
+{
+    if (!opened)
+    {
+        return;
+    }
+
+    const uint64_t frameTime = beginFrame(time);
+
+    payload.clear();
+    putVarint(payload, frameTime - lastTime);
+    payload.push_back(FRAME_EVENT);
+    payload.push_back((uint8_t)event.type);
+    putSigned(payload, (int64_t)event.x - eventX);
+    putSigned(payload, (int64_t)event.y - eventY);
+
+    eventX = event.x;
+    eventY = event.y;
+    lastTime = frameTime;
+    writeRecord(RECORD_DELTA);
+}
+
+uint64_t InputCaptureWriter::getBytesWritten() const
+{
+    return bytesWritten;
+}
+
+uint64_t InputCaptureWriter::getDroppedChunksCount() const
+{
+    return droppedChunks;
+}
+
+void InputCaptureWriter::setWritingPaused(bool paused)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    writingPaused = paused;
+    condition.notify_all();
+
+    if (!paused)
+    {
+        condition.wait(lock, [this]() { return pending.empty(); });
+    }
+}
+
+void InputCaptureWriter::writeLoop()
+{
+    bool failed = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this]() { return stopping || (!writingPaused && !pending.empty()); });
+        if (pending.empty())
+        {
+            break;
+        }
+
+        Chunk next = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+
+        if (next.keyframe)
+        {
+            keyframes.push_back({ next.keyframeTime * 1000, fileSize });
+        }
+
+        // Flushed per chunk, a crash loses at most the chunks still queued
+        file.write(reinterpret_cast<const char*>(next.data.data()), next.data.size());
+        file.flush();
+        if (!file && !failed)
+        {
+            std::cout << "Failed to write input capture file" << std::endl;
+            failed = true;
+        }
+
+        fileSize += next.data.size();
+        bytesWritten += next.data.size();
+        next.data.clear();
+
+        lock.lock();
+        spareBuffers.push_back(std::move(next.data));
+        condition.notify_all();
+    }
+}
+
+// Returns frame time in microseconds since start, writing a keyframe first when one is due
+uint64_t InputCaptureWriter::beginFrame(uint64_t time)
+{
+    if (!started)
+    {
+        startTime = time;
+        started = true;
+    }
+
+    uint64_t frameTime = time > startTime ? (time - startTime) / 1000 : 0;
+    frameTime = std::max(frameTime, lastTime);
+
+    if (keyframeDue || frameTime - keyframeTime >= KEYFRAME_INTERVAL)
+    {
+        writeKeyframe(frameTime);
+    }
+
+    return frameTime;
+}
+
+// Full mouse and window state, encoded against reset state so it decodes on its own
+void InputCaptureWriter::writeKeyframe(uint64_t time)
+{
+    static const std::vector<WindowData> noWindows;
+
+    // Every chunk starts with a keyframe unless it was split for size
+    flushChunk(false);
+    keyframeDue = false;
+    keyframeTime = time;
+    chunk.keyframe = true;
+    chunk.keyframeTime = time;
+
+    strings.clear();
+    eventX = 0;
+    eventY = 0;
+
+    uint8_t flags = FRAME_WINDOWS;
+    if (mouse.x != 0 || mouse.y != 0)
+    {
+        flags |= FRAME_MOUSE_MOVED;
+    }
+    if (mouse.buttons != 0)
+    {
+        flags |= FRAME_MOUSE_BUTTONS;
+    }
+
+    payload.clear();
+    putVarint(payload, time);
+    payload.push_back(flags);
+    if (flags & FRAME_MOUSE_MOVED)
+    {
+        putSigned(payload, mouse.x);
+        putSigned(payload, mouse.y);
+    }
+    if (flags & FRAME_MOUSE_BUTTONS)
+    {
+        payload.push_back(mouse.buttons);
+    }
+    encodeWindows(windows, noWindows);
+
+    lastTime = time;
+    writeRecord(RECORD_KEYFRAME);
+}
+
+void InputCaptureWriter::writeRecord(uint8_t type)
+{
+    if (chunk.data.capacity() < CHUNK_SIZE)
+    {
+        chunk.data.reserve(CHUNK_SIZE * 2);
+    }
+
+    chunk.data.push_back(type);
+    putVarint(chunk.data, payload.size());
+    chunk.data.insert(chunk.data.end(), payload.begin(), payload.end());
+
+    if (chunk.data.size() >= CHUNK_SIZE)
+    {
+        flushChunk(false);
+    }
+}
+
+// Hands current chunk to writer thread, or drops it if the queue is full and waiting isn't asked for
+void InputCaptureWriter::flushChunk(bool wait)
+{
+    if (chunk.data.empty())
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (wait)
+    {
+        condition.wait(lock, [this]() { return pending.size() < MAX_PENDING_CHUNKS; });
+    }
+
+    if (pending.size() >= MAX_PENDING_CHUNKS)
+    {
+        // Following deltas would refer to lost frames
+        droppedChunks++;
+        chunk.data.clear();
+        chunk.keyframe = false;
+        keyframeDue = true;
+        return;
+    }
+
+    pending.push_back(std::move(chunk));
+    chunk = Chunk();
+    if (!spareBuffers.empty())
+    {
+        chunk.data = std::move(spareBuffers.back());
+        spareBuffers.pop_back();
+    }
+
+    lock.unlock();
+    condition.notify_all();
+}
+
+void InputCaptureWriter::encodeWindows(const std::vector<WindowData>& next, const std::vector<WindowData>& previous)
+{
+    windowIndices.clear();
+    for (size_t i = 0; i < previous.size(); i++)
+    {
+        windowIndices[previous[i].id] = (uint32_t)i;
+    }
+
+    putVarint(payload, next.size());
+
+    size_t expected = 0; // Previous index that continues the list
+    uint64_t run = 0;
+    auto flushRun = [this, &run]()
+        {
+            if (run > 0)
+            {
+                putVarint(payload, OP_COPY | (run << 2));
+                run = 0;
+            }
+        };
+
+    for (const WindowData& window : next)
+    {
+        auto it = windowIndices.find(window.id);
+        if (it == windowIndices.end())
+        {
+            flushRun();
+            putVarint(payload, OP_ADDED);
+            putVarint(payload, window.id);
+            encodeString(window.title);
+            encodeString(window.className);
+            putSigned(payload, window.x);
+            putSigned(payload, window.y);
+            putSigned(payload, window.w);
+            putSigned(payload, window.h);
+            putSigned(payload, window.zOrder);
+            continue;
+        }
+
+        const size_t index = it->second;
+        const WindowData& old = previous[index];
+
+        uint8_t mask = 0;
+        mask |= window.x != old.x ? FIELD_X : 0;
+        mask |= window.y != old.y ? FIELD_Y : 0;
+        mask |= window.w != old.w ? FIELD_W : 0;
+        mask |= window.h != old.h ? FIELD_H : 0;
+        mask |= window.zOrder != old.zOrder ? FIELD_Z_ORDER : 0;
+        mask |= window.title != old.title ? FIELD_TITLE : 0;
+        mask |= window.className != old.className ? FIELD_CLASS_NAME : 0;
+
+        if (index == expected && mask == 0)
+        {
+            run++;
+            expected++;
+            continue;
+        }
+
+        flushRun();
+        putVarint(payload, OP_CHANGED | (zigzag((int64_t)index - (int64_t)expected) << 2));
+        payload.push_back(mask);
+        if (mask & FIELD_X) putSigned(payload, (int64_t)window.x - old.x);
+        if (mask & FIELD_Y) putSigned(payload, (int64_t)window.y - old.y);
+        if (mask & FIELD_W) putSigned(payload, (int64_t)window.w - old.w);
+        if (mask & FIELD_H) putSigned(payload, (int64_t)window.h - old.h);
+        if (mask & FIELD_Z_ORDER) putSigned(payload, (int64_t)window.zOrder - old.zOrder);
+        if (mask & FIELD_TITLE) encodeString(window.title);
+        if (mask & FIELD_CLASS_NAME) encodeString(window.className);
+
+        expected = index + 1;
+    }
+    flushRun();
+}
+
+// Reference to an earlier string plus one, or zero followed by the new string's length and code units
+void InputCaptureWriter::encodeString(const std::wstring& text)
+{
+    auto it = strings.find(text);
+    if (it != strings.end())
+    {
+        putVarint(payload, (uint64_t)it->second + 1);
+        return;
+    }
+
+    putVarint(payload, 0);
+    putVarint(payload, text.size());
+    for (wchar_t unit : text)
+    {
+        putVarint(payload, (uint64_t)unit);
+    }
+
+    const uint32_t index = (uint32_t)strings.size();
+    strings.emplace(text, index);
+}
+
+
+bool InputCaptureReader::open(const std::string& path)
+{
+    file.close();
+    file.clear();
+    file.open(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to open input capture file: " << path << std::endl;
+        return false;
+    }
+
+    const std::streamoff size = file.tellg();
+    fileSize = size > 0 ? (uint64_t)size : 0;
+    file.seekg(0);
+
+    Header header;
+    if (fileSize < sizeof(Header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+    {
+        std::cout << "Input capture file was written by another version: " << path << std::endl;
+        return false;
+    }
+
+    screenWidth = header.screenWidth;
+    screenHeight = header.screenHeight;
+
+    if (!findKeyframes())
+    {
+        std::cout << "Input capture file has no keyframes: " << path << std::endl;
+        return false;
+    }
+
+    return seek(0);
+}
+
+void InputCaptureReader::getScreenResolution(int& w, int& h) const
+{
+    w = screenWidth;
+    h = screenHeight;
+}
+
+const std::vector<InputKeyframe>& InputCaptureReader::getKeyframes() const
+{
+    return keyframes;
+}
+
+bool InputCaptureReader::seek(uint64_t newTime)
+{
+    if (keyframes.empty())
+    {
+        return false;
+    }
+
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), newTime,
+        [](uint64_t value, const InputKeyframe& keyframe) { return value < keyframe.time; });
+    if (it != keyframes.begin())
+    {
+        --it;
+    }
+
+    seekTo(it->offset);
+    hasPending = false;
+    ended = false;
+    clearEvents();
+
+    uint8_t type = 0;
+    if (!readRecord(type, pendingData) || type != RECORD_KEYFRAME || !applyRecord(type, pendingData))
+    {
+        std::cout << "Input capture keyframe is damaged" << std::endl;
+        ended = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool InputCaptureReader::advance(uint64_t newTime)
+{
+    const uint64_t target = newTime / 1000;
+    while (true)
+    {
+        if (!hasPending && !readPending())
+        {
+            return false;
+        }
+
+        if (pendingTime > target)
+        {
+            return true;
+        }
+
+        hasPending = false;
+        if (!applyRecord(pendingType, pendingData))
+        {
+            std::cout << "Input capture frame is damaged" << std::endl;
+            ended = true;
+            return false;
+        }
+    }
+}
+
+uint64_t InputCaptureReader::getTime() const
+{
+    return time * 1000;
+}
+
+const InputMouseState& InputCaptureReader::getMouse() const
+{
+    return mouse;
+}
+
+const std::vector<WindowData>& InputCaptureReader::getWindows() const
+{
+    return windows;
+}
+
+bool InputCaptureReader::popEvent(InputEvent& event)
+{
+    if (nextEvent >= events.size())
+    {
+        clearEvents();
+        return false;
+    }
+
+    event = events[nextEvent++];
+    return true;
+}
+
+void InputCaptureReader::clearEvents()
+{
+    events.clear();
+    nextEvent = 0;
+}
+
+void InputCaptureReader::seekTo(uint64_t offset)
+{
+    file.clear();
+    file.seekg((std::streamoff)offset);
+    position = offset;
+}
+
+// False at the end of records or when a record is cut short
+bool InputCaptureReader::readRecord(uint8_t& type, std::vector<uint8_t>& data)
+{
+    uint64_t offset = position;
+    if (offset >= recordsEnd)
+    {
+        return false;
+    }
+
+    int byte = file.get();
+    if (byte == std::ifstream::traits_type::eof())
+    {
+        return false;
+    }
+    type = (uint8_t)byte;
+    offset++;
+
+    uint64_t size = 0;
+    for (int shift = 0; ; shift += 7)
+    {
+        byte = file.get();
+        if (byte == std::ifstream::traits_type::eof() || shift >= 64)
+        {
+            return false;
+        }
+        offset++;
+
+        size |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            break;
+        }
+    }
+
+    if (offset > recordsEnd || size > recordsEnd - offset)
+    {
+        return false;
+    }
+
+    data.resize((size_t)size);
+    if (size > 0 && !file.read(reinterpret_cast<char*>(data.data()), (std::streamsize)size))
+    {
+        return false;
+    }
+
+    position = offset + size;
+    return true;
+}
+
+bool InputCaptureReader::readPending()
+{
+    if (ended)
+    {
+        return false;
+    }
+
+    uint64_t value = 0;
+    if (!readRecord(pendingType, pendingData) || (pendingType != RECORD_KEYFRAME && pendingType != RECORD_DELTA) ||
+        !Decoder(pendingData).varint(value))
+    {
+        ended = true;
+        return false;
+    }
+
+    pendingTime = pendingType == RECORD_KEYFRAME ? value : time + value;
+    hasPending = true;
+    return true;
+}
+
+// Reads index of a closed capture, or scans records of one that wasn't closed
+bool InputCaptureReader::findKeyframes()
+{
+    keyframes.clear();
+
+    uint64_t indexOffset = 0;
+    char indexMagic[sizeof(INDEX_MAGIC)] = {};
+    if (fileSize >= sizeof(Header) + TRAILER_SIZE)
+    {
+        seekTo(fileSize - TRAILER_SIZE);
+        file.read(reinterpret_cast<char*>(&indexOffset), sizeof(indexOffset));
+        file.read(indexMagic, sizeof(indexMagic));
+    }
+
+    if (file && memcmp(indexMagic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+        indexOffset >= sizeof(Header) && indexOffset < fileSize - TRAILER_SIZE)
+    {
+        recordsEnd = fileSize - TRAILER_SIZE;
+        seekTo(indexOffset);
+
+        uint8_t type = 0;
+        std::vector<uint8_t> data;
+        uint64_t count = 0;
+        if (readRecord(type, data) && type == RECORD_INDEX)
+        {
+            Decoder decoder(data);
+            bool valid = decoder.varint(count) && count <= data.size();
+
+            uint64_t keyframeTime = 0;
+            uint64_t offset = 0;
+            for (uint64_t i = 0; valid && i < count; i++)
+            {
+                uint64_t timeDelta = 0, offsetDelta = 0;
+                valid = decoder.varint(timeDelta) && decoder.varint(offsetDelta);
+                keyframeTime += timeDelta;
+                offset += offsetDelta;
+                valid = valid && offset >= sizeof(Header) && offset < indexOffset;
+                keyframes.push_back({ keyframeTime * 1000, offset });
+            }
+
+            if (valid && decoder.remaining() == 0)
+            {
+                recordsEnd = indexOffset;
+                return !keyframes.empty();
+            }
+        }
+
+        std::cout << "Input capture index is damaged, scanning frames" << std::endl;
+        keyframes.clear();
+    }
+
+    // Capture wasn't closed, a cut off last record is ignored
+    recordsEnd = fileSize;
+    seekTo(sizeof(Header));
+
+    uint8_t type = 0;
+    std::vector<uint8_t> data;
+    uint64_t offset = position;
+    while (readRecord(type, data))
+    {
+        uint64_t keyframeTime = 0;
+        if (type == RECORD_KEYFRAME && Decoder(data).varint(keyframeTime))
+        {
+            keyframes.push_back({ keyframeTime * 1000, offset });
+        }
+        offset = position;
+    }
+    recordsEnd = offset;
+
+    return !keyframes.empty();
+}
+
+bool InputCaptureReader::applyRecord(uint8_t type, const std::vector<uint8_t>& data)
+{
+    if (type == RECORD_KEYFRAME)
+    {
+        time = 0;
+        mouse = InputMouseState();
+        eventX = 0;
+        eventY = 0;
+        windows.clear();
+        strings.clear();
+    }
+
+    Decoder decoder(data);
+
+    uint64_t timeDelta = 0;
+    uint8_t flags = 0;
+    if (!decoder.varint(timeDelta) || !decoder.byte(flags))
+    {
+        return false;
+    }
+    time += timeDelta;
+
+    if (flags & FRAME_MOUSE_MOVED)
+    {
+        int64_t dx = 0, dy = 0;
+        if (!decoder.signedVarint(dx) || !decoder.signedVarint(dy))
+        {
+            return false;
+        }
+        mouse.x = (int)(mouse.x + dx);
+        mouse.y = (int)(mouse.y + dy);
+    }
+
+    if ((flags & FRAME_MOUSE_BUTTONS) && !decoder.byte(mouse.buttons))
+    {
+        return false;
+    }
+
+    if ((flags & FRAME_WINDOWS) && !decodeWindows(decoder))
+    {
+        return false;
+    }
+
+    if (flags & FRAME_EVENT)
+    {
+        uint8_t eventType = 0;
+        int64_t dx = 0, dy = 0;
+        if (!decoder.byte(eventType) || eventType > (uint8_t)InputEvent::Type::MouseMove ||
+            !decoder.signedVarint(dx) || !decoder.signedVarint(dy))
+        {
+            return false;
+        }
+
+        eventX = (int)(eventX + dx);
+        eventY = (int)(eventY + dy);
+
+        InputEvent event;
+        event.type = (InputEvent::Type)eventType;
+        event.x = eventX;
+        event.y = eventY;
+        events.push_back(event);
+    }
+
+    return decoder.remaining() == 0;
+}
+
+bool InputCaptureReader::decodeWindows(Decoder& decoder)
+{
+    // Copy runs are the only ops that add windows without using bytes
+    uint64_t count = 0;
+    if (!decoder.varint(count) || count > windows.size() + decoder.remaining())
+    {
+        return false;
+    }
+
+    // Slots are assigned, not rebuilt, so strings keep their buffers
+    nextWindows.resize((size_t)count);
+
+    size_t added = 0;
+    size_t expected = 0;
+    while (added < count)
+    {
+        uint64_t op = 0;
+        if (!decoder.varint(op))
+        {
+            return false;
+        }
+
+        const uint64_t argument = op >> 2;
+        switch (op & 3)
+        {
+        case OP_COPY:
+        {
+            if (argument == 0 || argument > count - added || argument > windows.size() - expected)
+            {
+                return false;
+            }
+            for (uint64_t i = 0; i < argument; i++)
+            {
+                nextWindows[added++] = windows[expected++];
+            }
+            break;
+        }
+        case OP_CHANGED:
+        {
+            const int64_t index = (int64_t)expected + unzigzag(argument);
+            uint8_t mask = 0;
+            if (index < 0 || index >= (int64_t)windows.size() || !decoder.byte(mask))
+            {
+                return false;
+            }
+
+            WindowData& window = nextWindows[added++];
+            window = windows[(size_t)index];
+
+            auto field = [&decoder, mask](int& value, uint8_t bit)
+                {
+                    int64_t delta = 0;
+                    if ((mask & bit) == 0)
+                    {
+                        return true;
+                    }
+                    if (!decoder.signedVarint(delta))
+                    {
+                        return false;
+                    }
+                    value = (int)(value + delta);
+                    return true;
+                };
+
+            if (!field(window.x, FIELD_X) || !field(window.y, FIELD_Y) || !field(window.w, FIELD_W) ||
+                !field(window.h, FIELD_H) || !field(window.zOrder, FIELD_Z_ORDER) ||
+                ((mask & FIELD_TITLE) && !decodeString(decoder, window.title)) ||
+                ((mask & FIELD_CLASS_NAME) && !decodeString(decoder, window.className)))
+            {
+                return false;
+            }
+
+            expected = (size_t)index + 1;
+            break;
+        }
+        case OP_ADDED:
+        {
+            WindowData& window = nextWindows[added++];
+
+            uint64_t id = 0;
+            int64_t x = 0, y = 0, w = 0, h = 0, zOrder = 0;
+            if (!decoder.varint(id) || !decodeString(decoder, window.title) || !decodeString(decoder, window.className) ||
+                !decoder.signedVarint(x) || !decoder.signedVarint(y) || !decoder.signedVarint(w) ||
+                !decoder.signedVarint(h) || !decoder.signedVarint(zOrder))
+            {
+                return false;
+            }
+
+            window.id = (size_t)id;
+            window.x = (int)x;
+            window.y = (int)y;
+            window.w = (int)w;
+            window.h = (int)h;
+            window.zOrder = (int)zOrder;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    windows.swap(nextWindows);
+    return true;
+}
+
+bool InputCaptureReader::decodeString(Decoder& decoder, std::wstring& text)
+{
+    uint64_t reference = 0;
+    if (!decoder.varint(reference))
+    {
+        return false;
+    }
+
+    if (reference > 0)
+    {
+        if (reference > strings.size())
+        {
+            return false;
+        }
+        text = strings[(size_t)reference - 1];
+        return true;
+    }
+
+    uint64_t length = 0;
+    if (!decoder.varint(length) || length > decoder.remaining())
+    {
+        return false;
+    }
+
+    text.resize((size_t)length);
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        uint64_t unit = 0;
+        if (!decoder.varint(unit))
+        {
+            return false;
+        }
+        text[i] = (wchar_t)unit;
+    }
+
+    strings.push_back(text);
+    return true;
+}
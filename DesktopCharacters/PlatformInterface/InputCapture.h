@@ -0,0 +1,189 @@
+#pragma once
+#include "BasePlatformInterface.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Capture of everything the simulation reads from the desktop: window lists, mouse and mouse events
+// File is a header followed by records. Keyframes hold full state, every other frame only
+// holds changes since the previous one: varint differences of rects and mouse, windows added
+// or removed, and titles or class names as references into a string table.
+// Table and differences restart at each keyframe, so replay can start from any of them.
+
+// Mouse event delivered to the overlay window
+struct InputEvent
+{
+    enum class Type : uint8_t
+    {
+        LeftMouseDown,
+        LeftMouseUp,
+        MouseMove
+    };
+
+    Type type = Type::MouseMove;
+    int x = 0, y = 0;
+};
+
+struct InputMouseState
+{
+    int x = 0, y = 0;
+    uint8_t buttons = 0; // Bit per MouseButton
+
+    bool operator==(const InputMouseState& other) const { return x == other.x && y == other.y && buttons == other.buttons; }
+    bool operator!=(const InputMouseState& other) const { return !(*this == other); }
+};
+
+struct InputKeyframe
+{
+    uint64_t time;   // Nanoseconds since capture start
+    uint64_t offset; // In file
+};
+
+// Encodes frames on the calling thread and writes them on its own
+// Encoded frames wait in a bounded queue; when disk can't keep up a whole chunk is dropped
+// and the next frame starts a new keyframe, so the file stays decodable around the gap.
+class InputCaptureWriter
+{
+public:
+    ~InputCaptureWriter();
+
+    bool open(const std::string& path, int screenWidth, int screenHeight);
+    bool isOpen() const;
+
+    // Writes queued chunks and keyframe index
+    void close();
+
+    // Times are platform nanoseconds and must not go back
+    void writeMouse(uint64_t time, const InputMouseState& newMouse); // Nothing is written if mouse didn't change
+    void writeWindows(uint64_t time, const std::vector<WindowData>& newWindows);
+    void writeEvent(uint64_t time, const InputEvent& event);
+
+    uint64_t getBytesWritten() const;
+    uint64_t getDroppedChunksCount() const;
+
+    // Stalls the writer thread like a disk that can't keep up, used by tests
+    // Resuming returns once every queued chunk was handed to the file
+    void setWritingPaused(bool paused);
+private:
+    static const uint64_t KEYFRAME_INTERVAL = 10000000; // In microseconds
+    static const size_t CHUNK_SIZE = 64 * 1024;
+    static const size_t MAX_PENDING_CHUNKS = 16;
+
+    struct Chunk
+    {
+        std::vector<uint8_t> data;
+        bool keyframe = false; // Starts with a keyframe
+        uint64_t keyframeTime = 0;
+    };
+
+    // Encoder, caller thread only
+    bool opened = false;
+    bool started = false;
+    uint64_t startTime = 0; // Platform nanoseconds of first frame
+    uint64_t lastTime = 0; // Microseconds since start
+    uint64_t keyframeTime = 0;
+    bool keyframeDue = true;
+
+    InputMouseState mouse;
+    int eventX = 0, eventY = 0; // Last event position
+    std::vector<WindowData> windows; // As of last frame
+    std::unordered_map<size_t, uint32_t> windowIndices; // Scratch, by id
+    std::unordered_map<std::wstring, uint32_t> strings; // Since last keyframe
+
+    std::vector<uint8_t> payload; // Scratch
+    Chunk chunk;
+
+    // Shared with writer thread
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Chunk> pending;
+    std::vector<std::vector<uint8_t>> spareBuffers;
+    bool stopping = false;
+    bool writingPaused = false;
+    std::thread thread;
+
+    // Writer thread only while it runs
+    std::ofstream file;
+    uint64_t fileSize = 0;
+    std::vector<InputKeyframe> keyframes;
+
+    std::atomic<uint64_t> bytesWritten{ 0 };
+    std::atomic<uint64_t> droppedChunks{ 0 };
+
+    void writeLoop();
+
+    uint64_t beginFrame(uint64_t time);
+    void writeKeyframe(uint64_t time);
+    void writeRecord(uint8_t type);
+    void flushChunk(bool wait);
+
+    void encodeWindows(const std::vector<WindowData>& next, const std::vector<WindowData>& previous);
+    void encodeString(const std::wstring& text);
+};
+
+// Reads a capture back, jumping between keyframes
+class InputCaptureReader
+{
+public:
+    bool open(const std::string& path);
+
+    void getScreenResolution(int& w, int& h) const;
+    const std::vector<InputKeyframe>& getKeyframes() const;
+
+    // Restores state of the last keyframe at or before time, false if capture has no keyframes
+    bool seek(uint64_t time);
+
+    // Applies every frame up to time, false once capture ended or a damaged frame was met
+    bool advance(uint64_t time);
+
+    // State as of last applied frame
+    uint64_t getTime() const;
+    const InputMouseState& getMouse() const;
+    const std::vector<WindowData>& getWindows() const;
+
+    // Events of applied frames, oldest first
+    bool popEvent(InputEvent& event);
+    void clearEvents();
+private:
+    struct Decoder;
+
+    std::ifstream file;
+    uint64_t fileSize = 0;
+    uint64_t position = 0; // In file
+    uint64_t recordsEnd = 0; // Index and trailer follow
+    int screenWidth = 0, screenHeight = 0;
+    std::vector<InputKeyframe> keyframes;
+
+    uint64_t time = 0; // Microseconds since start
+    InputMouseState mouse;
+    int eventX = 0, eventY = 0;
+    std::vector<WindowData> windows;
+    std::vector<WindowData> nextWindows; // Scratch
+    std::vector<std::wstring> strings;
+    std::vector<InputEvent> events;
+    size_t nextEvent = 0;
+
+    // Next record, read ahead to see its time
+    bool hasPending = false;
+    bool ended = false;
+    uint8_t pendingType = 0;
+    uint64_t pendingTime = 0;
+    std::vector<uint8_t> pendingData;
+
+    void seekTo(uint64_t offset);
+    bool readRecord(uint8_t& type, std::vector<uint8_t>& data);
+    bool readPending();
+    bool findKeyframes();
+
+    bool applyRecord(uint8_t type, const std::vector<uint8_t>& data);
+    bool decodeWindows(Decoder& decoder);
+    bool decodeString(Decoder& decoder, std::wstring& text);
+};
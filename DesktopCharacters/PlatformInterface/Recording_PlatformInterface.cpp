@@ -0,0 +1,68 @@
+#include "Recording_PlatformInterface.h"
+
+Recording_PlatformInterface::Recording_PlatformInterface(std::unique_ptr<BasePlatformInterface> source) :
+    source(std::move(source))
+{
+}
+
+bool Recording_PlatformInterface::open(const std::string& path)
+{
+    int w = 0, h = 0;
+    source->getScreenResolution(w, h);
+    return writer.open(path, w, h);
+}
+
+void Recording_PlatformInterface::start()
+{
+    source->start();
+}
+
+bool Recording_PlatformInterface::getMouseButtonPressed(MouseButton button) const
+{
+    recordMouse();
+    return source->getMouseButtonPressed(button);
+}
+
+void Recording_PlatformInterface::getGlobalMousePosition(int& x, int& y) const
+{
+    recordMouse();
+    source->getGlobalMousePosition(x, y);
+}
+
+void Recording_PlatformInterface::getScreenResolution(int& w, int& h) const
+{
+    source->getScreenResolution(w, h);
+}
+
+void Recording_PlatformInterface::getWindows(std::vector<WindowData>& result) const
+{
+    source->getWindows(result);
+    writer.writeWindows(getTimeNanoseconds(), result);
+}
+
+void Recording_PlatformInterface::recordEvent(const InputEvent& event)
+{
+    writer.writeEvent(getTimeNanoseconds(), event);
+}
+
+const InputCaptureWriter& Recording_PlatformInterface::getWriter() const
+{
+    return writer;
+}
+
+uint64_t Recording_PlatformInterface::getMonotonicTimeNanoseconds() const
+{
+    return source->getTimeNanoseconds();
+}
+
+// Whole mouse state, so replay answers every button and position query the same way
+void Recording_PlatformInterface::recordMouse() const
+{
+    InputMouseState mouse;
+    source->getGlobalMousePosition(mouse.x, mouse.y);
+    mouse.buttons |= source->getMouseButtonPressed(MouseButton::Left) ? 1 << (int)MouseButton::Left : 0;
+    mouse.buttons |= source->getMouseButtonPressed(MouseButton::Right) ? 1 << (int)MouseButton::Right : 0;
+    mouse.buttons |= source->getMouseButtonPressed(MouseButton::Middle) ? 1 << (int)MouseButton::Middle : 0;
+
+    writer.writeMouse(getTimeNanoseconds(), mouse);
+}
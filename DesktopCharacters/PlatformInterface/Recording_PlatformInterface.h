@@ -0,0 +1,37 @@
+#pragma once
+#include "BasePlatformInterface.h"
+#include "InputCapture.h"
+
+#include <memory>
+#include <string>
+
+// Forwards to another platform interface and captures what it returns
+// Mouse is captured whenever it's queried and has changed, window lists on every poll.
+class Recording_PlatformInterface : public BasePlatformInterface
+{
+public:
+    explicit Recording_PlatformInterface(std::unique_ptr<BasePlatformInterface> source);
+
+    bool open(const std::string& path);
+
+    void start() override;
+
+    bool getMouseButtonPressed(MouseButton button) const override;
+    void getGlobalMousePosition(int& x, int& y) const override;
+
+    void getScreenResolution(int& w, int& h) const override;
+
+    void getWindows(std::vector<WindowData>& result) const override;
+
+    // Events reach the overlay window, not the platform interface, so they are handed over here
+    void recordEvent(const InputEvent& event);
+
+    const InputCaptureWriter& getWriter() const;
+protected:
+    uint64_t getMonotonicTimeNanoseconds() const override;
+private:
+    std::unique_ptr<BasePlatformInterface> source;
+    mutable InputCaptureWriter writer; // Queries are const, capturing them isn't
+
+    void recordMouse() const;
+};
@@ -0,0 +1,81 @@
+#include "Replay_PlatformInterface.h"
+
+#include <iostream>
+
+bool Replay_PlatformInterface::open(const std::string& path, double startSeconds, double newSpeed)
+{
+    if (!reader.open(path))
+    {
+        return false;
+    }
+
+    startTime = startSeconds > 0.0 ? (uint64_t)(startSeconds * 1e9) : 0;
+    speed = newSpeed > 0.0 ? newSpeed : 1.0;
+
+    // Events before the start point already happened
+    if (!reader.seek(startTime) || !reader.advance(startTime))
+    {
+        std::cout << "Input capture ends before " << startSeconds << " seconds" << std::endl;
+        return false;
+    }
+    reader.clearEvents();
+
+    return true;
+}
+
+void Replay_PlatformInterface::start()
+{
+    realStartTime = std::chrono::steady_clock::now();
+}
+
+bool Replay_PlatformInterface::getMouseButtonPressed(MouseButton button) const
+{
+    sync();
+    return (reader.getMouse().buttons & (1 << (int)button)) != 0;
+}
+
+void Replay_PlatformInterface::getGlobalMousePosition(int& x, int& y) const
+{
+    sync();
+    x = reader.getMouse().x;
+    y = reader.getMouse().y;
+}
+
+void Replay_PlatformInterface::getScreenResolution(int& w, int& h) const
+{
+    reader.getScreenResolution(w, h);
+}
+
+void Replay_PlatformInterface::getWindows(std::vector<WindowData>& result) const
+{
+    sync();
+    const std::vector<WindowData>& windows = reader.getWindows();
+    result.insert(result.end(), windows.begin(), windows.end());
+}
+
+bool Replay_PlatformInterface::pollEvent(InputEvent& event)
+{
+    sync();
+    return reader.popEvent(event);
+}
+
+uint64_t Replay_PlatformInterface::getMonotonicTimeNanoseconds() const
+{
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - realStartTime;
+    return startTime + (uint64_t)(elapsed.count() * speed);
+}
+
+// Last state stays in place once capture ends
+void Replay_PlatformInterface::sync() const
+{
+    if (finished)
+    {
+        return;
+    }
+
+    if (!reader.advance(getTimeNanoseconds()))
+    {
+        std::cout << "Input capture replay finished" << std::endl;
+        finished = true;
+    }
+}
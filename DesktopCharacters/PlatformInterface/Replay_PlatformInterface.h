@@ -0,0 +1,39 @@
+#pragma once
+#include "BasePlatformInterface.h"
+#include "InputCapture.h"
+
+#include <chrono>
+#include <string>
+
+// Plays back a capture written through Recording_PlatformInterface
+// Clock is capture time, running from the start point at given speed once start() is called.
+// Queries return captured state as of that time; captured events are taken with pollEvent().
+class Replay_PlatformInterface : public BasePlatformInterface
+{
+public:
+    // Jumps to the keyframe before startSeconds, then fast forwards to it
+    bool open(const std::string& path, double startSeconds, double newSpeed);
+
+    void start() override;
+
+    bool getMouseButtonPressed(MouseButton button) const override;
+    void getGlobalMousePosition(int& x, int& y) const override;
+
+    void getScreenResolution(int& w, int& h) const override;
+
+    void getWindows(std::vector<WindowData>& result) const override;
+
+    bool pollEvent(InputEvent& event);
+protected:
+    uint64_t getMonotonicTimeNanoseconds() const override;
+private:
+    mutable InputCaptureReader reader; // Advanced by queries
+    mutable bool finished = false;
+
+    // Set before start(), read-only after, so the clock can be read from any thread
+    uint64_t startTime = 0;
+    double speed = 1.0;
+    std::chrono::steady_clock::time_point realStartTime;
+
+    void sync() const;
+};
@@ -128,3 +128,20 @@ void Windows_PlatformInterface::getWindows(std::vector<WindowData>& result) cons
     windowDataCollectionVector = &result;
     EnumWindows(EnumWindowsCallback, 0);
 }
+
+uint64_t Windows_PlatformInterface::getMonotonicTimeNanoseconds() const
+{
+    static const uint64_t frequency = []()
+        {
+            LARGE_INTEGER value;
+            QueryPerformanceFrequency(&value);
+            return (uint64_t)value.QuadPart;
+        }();
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+
+    // Split to avoid overflow of ticks * 1e9
+    return (ticks / frequency) * 1000000000ull + (ticks % frequency) * 1000000000ull / frequency;
+}
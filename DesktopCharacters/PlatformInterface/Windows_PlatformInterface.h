@@ -12,5 +12,7 @@ public:
     void getScreenResolution(int& w, int& h) const override;
 
     void getWindows(std::vector<WindowData>& result) const override;
+protected:
+    uint64_t getMonotonicTimeNanoseconds() const override;
 };
 
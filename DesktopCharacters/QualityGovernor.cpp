@@ -0,0 +1,128 @@
+#include "QualityGovernor.h"
+
+#include "Core/Profiler.h"
+
+#include <algorithm>
+
+QualityGovernor::QualityGovernor(const Settings& settings) :
+    settings(settings)
+{
+}
+
+bool QualityGovernor::update(float deltaTime)
+{
+    evaluationTimer += deltaTime;
+    if (evaluationTimer < settings.evaluationPeriod)
+    {
+        return false;
+    }
+    const float elapsed = evaluationTimer;
+    evaluationTimer = 0.0f;
+
+    // Either thread running late shows up as a late frame
+    const double simulationPercentile = Profiler::getFrameTimePercentile(settings.quantile, settings.evaluationFrames);
+    lastPercentile = std::max(simulationPercentile, getRenderFrameTimePercentile());
+
+    const int current = (int)level;
+    int next = current;
+
+    if (lastPercentile > settings.frameBudget)
+    {
+        headroomTime = 0.0f;
+        if (current + 1 < (int)Level::Count)
+        {
+            next = current + 1;
+        }
+    }
+    else if (lastPercentile < settings.frameBudget * settings.headroom)
+    {
+        headroomTime += elapsed;
+        if (headroomTime >= settings.restoreDelay && current > 0)
+        {
+            next = current - 1;
+            headroomTime = 0.0f;
+        }
+    }
+    else
+    {
+        headroomTime = 0.0f;
+    }
+
+    if (next == current)
+    {
+        return false;
+    }
+
+    level = (Level)next;
+    transitionsCount++;
+    return true;
+}
+
+void QualityGovernor::addRenderFrameTime(double frameTime)
+{
+    std::lock_guard<std::mutex> lock(renderFrameTimesMutex);
+    renderFrameTimes.push(frameTime);
+}
+
+double QualityGovernor::getRenderFrameTimePercentile()
+{
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(renderFrameTimesMutex);
+        count = std::min(renderFrameTimes.size(), (size_t)std::max(settings.evaluationFrames, 1));
+        const size_t first = renderFrameTimes.size() - count;
+        for (size_t i = 0; i < count; i++)
+        {
+            renderFrameTimesScratch[i] = renderFrameTimes[first + i];
+        }
+    }
+
+    if (count == 0)
+    {
+        return 0.0;
+    }
+
+    size_t index = (size_t)(settings.quantile * (count - 1) + 0.5);
+    index = std::min(index, count - 1);
+    std::nth_element(renderFrameTimesScratch, renderFrameTimesScratch + index, renderFrameTimesScratch + count);
+    return renderFrameTimesScratch[index];
+}
+
+QualityGovernor::Level QualityGovernor::getLevel() const
+{
+    return level;
+}
+
+bool QualityGovernor::isAtLeast(Level other) const
+{
+    return (int)level >= (int)other;
+}
+
+uint64_t QualityGovernor::getTransitionsCount() const
+{
+    return transitionsCount;
+}
+
+double QualityGovernor::getLastPercentile() const
+{
+    return lastPercentile;
+}
+
+const char* QualityGovernor::getLevelName(Level level)
+{
+    switch (level)
+    {
+    case Level::Full:
+        return "Full";
+    case Level::NoObstacleOverlay:
+        return "No obstacle overlay";
+    case Level::ReducedDistantPhysics:
+        return "Reduced distant physics";
+    case Level::ReducedWindowPolling:
+        return "Reduced window polling";
+    case Level::MinimalWindowPolling:
+        return "Minimal window polling";
+    default:
+        return "Unknown";
+    }
+}
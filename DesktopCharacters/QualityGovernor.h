@@ -0,0 +1,64 @@
+#pragma once
+#include "Core/RingBuffer.h"
+
+#include <cstdint>
+#include <mutex>
+
+// Keeps frame time within budget by stepping through quality levels
+// Simulation frame times come from Profiler, render frame times are reported by render thread;
+// the worse of the two percentiles is used. Quality drops as soon as it goes over budget
+// and is restored one level at a time after headroom has lasted for a while.
+class QualityGovernor
+{
+public:
+    // Higher levels include everything the lower ones give up
+    enum class Level : int
+    {
+        Full,
+        NoObstacleOverlay,      // Obstacle debug lines aren't drawn
+        ReducedDistantPhysics,  // Character LOD distances halved
+        ReducedWindowPolling,   // Windows polled at 10 Hz instead of 15 Hz
+        MinimalWindowPolling,   // Windows polled at 5 Hz
+        Count
+    };
+
+    struct Settings
+    {
+        double frameBudget = 16.0;      // ms
+        double quantile = 0.9;
+        double headroom = 0.6;          // Fraction of budget under which quality can be restored
+        int evaluationFrames = 60;      // Most recent frames used for percentile
+        float evaluationPeriod = 1.0f;  // seconds
+        float restoreDelay = 5.0f;      // seconds of headroom before going up a level
+    };
+
+    QualityGovernor() = default;
+    explicit QualityGovernor(const Settings& settings);
+
+    // Returns true if level changed
+    bool update(float deltaTime);
+
+    // Called from render thread once per drawn frame, in milliseconds
+    void addRenderFrameTime(double frameTime);
+
+    Level getLevel() const;
+    bool isAtLeast(Level level) const;
+    uint64_t getTransitionsCount() const;
+    double getLastPercentile() const;
+
+    static const char* getLevelName(Level level);
+private:
+    Settings settings;
+    Level level = Level::Full;
+
+    float evaluationTimer = 0.0f;
+    float headroomTime = 0.0f;
+    double lastPercentile = 0.0;
+    uint64_t transitionsCount = 0;
+
+    std::mutex renderFrameTimesMutex;
+    RingBuffer<double, 256> renderFrameTimes;
+    double renderFrameTimesScratch[256]; // Sorted copy, only used by update()
+
+    double getRenderFrameTimePercentile();
+};
@@ -0,0 +1,254 @@
+#include "SimulationState.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static_assert(std::is_trivially_copyable<SimulationState::CharacterState>::value, "CharacterState is saved as raw bytes");
+static_assert(std::is_trivially_copyable<SimulationState::WindowState>::value, "WindowState is saved as raw bytes");
+static_assert(std::is_trivially_copyable<Character::Data>::value, "Character::Data is saved as raw bytes");
+static_assert(std::is_trivially_copyable<Crowd::Data>::value, "Crowd::Data is saved as raw bytes");
+
+namespace
+{
+    const char MAGIC[4] = { 'D', 'C', 'S', 'S' };
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+
+        // Layout check, raw structs of another build are rejected
+        uint32_t characterStateSize;
+        uint32_t characterDataSize;
+        uint32_t windowStateSize;
+        uint32_t crowdDataSize;
+    };
+
+    class Writer
+    {
+    public:
+        explicit Writer(std::vector<char>& buffer) : buffer(buffer) {}
+
+        void bytes(const void* data, size_t size)
+        {
+            const char* begin = static_cast<const char*>(data);
+            buffer.insert(buffer.end(), begin, begin + size);
+        }
+
+        template<typename T>
+        void value(const T& item)
+        {
+            bytes(&item, sizeof(T));
+        }
+
+        template<typename T>
+        void array(const std::vector<T>& items)
+        {
+            value((uint32_t)items.size());
+            bytes(items.data(), items.size() * sizeof(T));
+        }
+    private:
+        std::vector<char>& buffer;
+    };
+
+    // Reads straight into destination arrays
+    // Every read is checked against file size, a truncated file fails instead of allocating garbage sizes
+    class Reader
+    {
+    public:
+        Reader(std::istream& stream, size_t size) : stream(stream), remaining(size) {}
+
+        bool bytes(void* target, size_t count)
+        {
+            if (count > remaining || !stream.read(static_cast<char*>(target), count))
+            {
+                return false;
+            }
+            remaining -= count;
+            return true;
+        }
+
+        template<typename T>
+        bool value(T& item)
+        {
+            return bytes(&item, sizeof(T));
+        }
+
+        template<typename T>
+        bool array(std::vector<T>& items)
+        {
+            uint32_t count = 0;
+            if (!value(count) || count > remaining / sizeof(T))
+            {
+                return false;
+            }
+            items.resize(count);
+            return bytes(items.data(), count * sizeof(T));
+        }
+
+        bool string(std::string& text)
+        {
+            uint32_t count = 0;
+            if (!value(count) || count > remaining)
+            {
+                return false;
+            }
+            text.resize(count);
+            return bytes(&text[0], count);
+        }
+
+        bool atEnd() const { return remaining == 0; }
+    private:
+        std::istream& stream;
+        size_t remaining;
+    };
+}
+
+uint16_t SimulationState::getCharacterType(const Character::Data& data)
+{
+    for (size_t i = 0; i < characterTypes.size(); i++)
+    {
+        if (memcmp(&characterTypes[i], &data, sizeof(Character::Data)) == 0)
+        {
+            return (uint16_t)i;
+        }
+    }
+
+    characterTypes.push_back(data);
+    return (uint16_t)(characterTypes.size() - 1);
+}
+
+bool SimulationState::save(const std::string& path) const
+{
+    std::vector<char> buffer;
+    buffer.reserve(sizeof(Header) + characterTypes.size() * sizeof(Character::Data) + characters.size() * sizeof(CharacterState) +
+        windows.size() * sizeof(WindowState) + (crowdPositions.size() + crowdVelocities.size()) * sizeof(Vec2) + randomState.size() + 64);
+
+    Writer writer(buffer);
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.characterStateSize = sizeof(CharacterState);
+    header.characterDataSize = sizeof(Character::Data);
+    header.windowStateSize = sizeof(WindowState);
+    header.crowdDataSize = sizeof(Crowd::Data);
+    writer.value(header);
+
+    writer.value(worldSize);
+    writer.array(characterTypes);
+    writer.array(characters);
+    writer.value(draggedCharacter);
+    writer.value(dragOffset);
+    writer.array(windows);
+
+    writer.value((uint8_t)crowdEnabled);
+    writer.value(crowdData);
+    writer.array(crowdPositions);
+    writer.array(crowdVelocities);
+
+    writer.value((uint32_t)randomState.size());
+    writer.bytes(randomState.data(), randomState.size());
+
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "Failed to open simulation state file: " << temporaryPath << std::endl;
+            return false;
+        }
+
+        file.write(buffer.data(), buffer.size());
+        file.close();
+        if (!file)
+        {
+            std::cout << "Failed to write simulation state file: " << temporaryPath << std::endl;
+            return false;
+        }
+    }
+
+    // Old save is replaced in one step, there is no moment without a valid file
+#ifdef _WIN32
+    const bool replaced = MoveFileExW(std::filesystem::path(temporaryPath).c_str(), std::filesystem::path(path).c_str(),
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    const bool replaced = std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!replaced)
+    {
+        std::cout << "Failed to replace simulation state file: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool SimulationState::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+
+    Reader reader(file, fileSize > 0 ? (size_t)fileSize : 0);
+
+    Header header;
+    if (!reader.value(header) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.characterStateSize != sizeof(CharacterState) || header.characterDataSize != sizeof(Character::Data) ||
+        header.windowStateSize != sizeof(WindowState) || header.crowdDataSize != sizeof(Crowd::Data))
+    {
+        std::cout << "Simulation state file was written by another version: " << path << std::endl;
+        return false;
+    }
+
+    uint8_t crowd = 0;
+    bool valid = reader.value(worldSize) &&
+        reader.array(characterTypes) &&
+        reader.array(characters) &&
+        reader.value(draggedCharacter) &&
+        reader.value(dragOffset) &&
+        reader.array(windows) &&
+        reader.value(crowd) &&
+        reader.value(crowdData) &&
+        reader.array(crowdPositions) &&
+        reader.array(crowdVelocities) &&
+        reader.string(randomState) &&
+        reader.atEnd();
+
+    crowdEnabled = crowd != 0;
+    valid = valid && crowdPositions.size() == crowdVelocities.size() &&
+        draggedCharacter >= -1 && draggedCharacter < (int32_t)characters.size();
+
+    // Enums and bools are read as raw bytes too, out of range values would index past tables
+    for (size_t i = 0; valid && i < characters.size(); i++)
+    {
+        uint8_t facingLeft = 0;
+        memcpy(&facingLeft, &characters[i].facingLeft, sizeof(facingLeft));
+
+        const int animationState = (int)characters[i].animationState;
+        valid = characters[i].type < characterTypes.size() &&
+            animationState >= (int)Character::AnimationState::Idle && animationState <= (int)Character::AnimationState::Drag &&
+            facingLeft <= 1;
+    }
+
+    if (!valid)
+    {
+        std::cout << "Simulation state file is damaged: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
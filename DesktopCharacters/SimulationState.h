@@ -0,0 +1,65 @@
+#pragma once
+#include "Core/Vec2.h"
+
+#include "Character.h"
+#include "Crowd.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Flat copy of everything needed to resume simulation after a restart
+// Captured between steps, then saved on another thread while simulation goes on.
+// Capture is a plain copy rather than copy-on-write: characters are separate objects the simulation
+// mutates in place, and copying 10k of them takes about 0.2 ms, well under one step.
+// File is a small header followed by raw arrays of this build's structs,
+// so it is only read back by builds with the same version and struct sizes.
+struct SimulationState
+{
+    static const uint32_t VERSION = 2; // 2: friction is per second
+
+    struct CharacterState
+    {
+        Vec2 position;
+        Vec2 velocity;
+        Vec2 size;
+        float animationTime;
+        uint16_t type; // Index into characterTypes
+        Character::AnimationState animationState;
+        bool facingLeft;
+    };
+
+    // Cached window rect and its motion filter, so first poll after restart continues tracking
+    struct WindowState
+    {
+        uint64_t id = 0;
+        int32_t x = 0, y = 0, w = 0, h = 0;
+        int32_t zOrder = 0;
+        Vec2 filterPosition;
+        Vec2 filterVelocity;
+    };
+
+    Vec2 worldSize;
+
+    std::vector<Character::Data> characterTypes; // Shared by many characters, stored once
+    std::vector<CharacterState> characters;
+
+    int32_t draggedCharacter = -1; // Index into characters
+    Vec2 dragOffset;
+
+    std::vector<WindowState> windows;
+
+    bool crowdEnabled = false;
+    Crowd::Data crowdData;
+    std::vector<Vec2> crowdPositions;
+    std::vector<Vec2> crowdVelocities;
+
+    std::string randomState; // Random engine state, as written by Random::GetState()
+
+    // Index of data in characterTypes, added if missing
+    uint16_t getCharacterType(const Character::Data& data);
+
+    // Written to a temporary file first, so a crash mid-write keeps previous save
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
@@ -1,11 +1,28 @@
 #include "BaseWindow.h"
 
-void BaseWindow::setCallback(EventCallback cb)
+void BaseWindow::setEventQueue(WindowEventQueue* queue, const BasePlatformInterface* clock)
 {
-    callback = std::move(cb);
+    eventQueue = queue;
+    eventClock = clock;
 }
 
 BaseRenderer* BaseWindow::getRenderer() const
 {
     return renderer.get();
 }
+
+// Full queue drops the event, counted by the queue
+// Without a clock events keep zero timestamps
+void BaseWindow::pushEvent(WindowEvent& evt)
+{
+    if (!eventQueue)
+    {
+        return;
+    }
+
+    if (eventClock)
+    {
+        evt.timestamp = eventClock->getTimeSeconds();
+    }
+    eventQueue->push(evt);
+}
@@ -1,7 +1,8 @@
 #pragma once
+#include "Core/EventQueue.h"
+#include "PlatformInterface/BasePlatformInterface.h"
 #include "Renderer/BaseRenderer.h"
 
-#include <functional>
 #include <memory>
 
 struct WindowEvent
@@ -32,8 +33,14 @@ struct WindowEvent
     // Resize info
     int width = 0;
     int height = 0;
+
+    // When event was received, in seconds of platform clock
+    double timestamp = 0.0;
 };
 
+// Filled by window message handling, drained by the simulation at a point of its choosing
+using WindowEventQueue = EventQueue<WindowEvent, 1024>;
+
 struct InitWindowParams
 {
     int width;              
@@ -51,8 +58,6 @@ struct InitWindowParams
 class BaseWindow
 {
 public:
-    using EventCallback = std::function<void(const WindowEvent&)>;
-
     virtual ~BaseWindow() = default;
 
     virtual bool createWindow(const InitWindowParams& params) = 0;
@@ -60,10 +65,15 @@ public:
 
     virtual bool isValid() const = 0;
 
-    void setCallback(EventCallback cb);
+    // Events are pushed stamped with clock time, none before a queue is set
+    // Clock may be null, events are then not stamped
+    void setEventQueue(WindowEventQueue* queue, const BasePlatformInterface* clock);
 
     BaseRenderer* getRenderer() const;
 protected:
-    EventCallback callback;
+    WindowEventQueue* eventQueue = nullptr;
+    const BasePlatformInterface* eventClock = nullptr;
     std::unique_ptr<BaseRenderer> renderer;
+
+    void pushEvent(WindowEvent& evt);
 };
@@ -2,7 +2,10 @@
 #include "Core/Color.h"
 #include "Core/Vec2.h"
 
+#include "Sprite.h"
+
 #include <string>
+#include <vector>
 
 class BaseRenderer
 {
@@ -23,7 +26,15 @@ public:
 	void drawLine(const Vec2& start, const Vec2& end, const Color& color, float strokeWidth = 2.0f);
 
 	// Text
-	virtual void drawText(const std::wstring& text, float x, float y, float w, float h, const Color& color) = 0;
-	void drawText(const std::wstring& text, const Vec2& position, const Vec2& size, const Color& color);
+	virtual void drawText(const std::wstring& text, float x, float y, float w, float h, const Color& color, float fontSize = 48.0f) = 0;
+	void drawText(const std::wstring& text, const Vec2& position, const Vec2& size, const Color& color, float fontSize = 48.0f);
+
+	// Sprites
+	// Atlas image is decoded once and kept until released
+	// Both calls belong to the same thread, which has COM initialized on Windows
+	virtual bool loadSpriteAtlas(const std::wstring& imagePath) = 0;
+	virtual void releaseSpriteAtlas() = 0;
+	virtual bool hasSpriteAtlas() const = 0;
+	virtual void drawSprites(const std::vector<Sprite>& sprites) = 0;
 };
 
@@ -0,0 +1,13 @@
+#pragma once
+
+// Single textured quad taken from the loaded sprite atlas
+struct Sprite
+{
+	// Destination rectangle on screen
+	float x = 0.0f, y = 0.0f, w = 0.0f, h = 0.0f;
+
+	// Source rectangle in atlas, in pixels
+	float srcX = 0.0f, srcY = 0.0f, srcW = 0.0f, srcH = 0.0f;
+
+	bool flipX = false;
+};
@@ -0,0 +1,113 @@
+#include "SpriteAtlas.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Bigger counts are taken for a broken file rather than an animation
+static const int MAX_FRAMES_PER_ANIMATION = 1024;
+
+// For messages, console runs in UTF-8
+static std::string toUtf8(const std::filesystem::path& path)
+{
+	const std::u8string text = path.u8string();
+	return std::string(text.begin(), text.end());
+}
+
+bool SpriteAtlas::load(const std::filesystem::path& descriptionPath)
+{
+	imagePath.clear();
+	frames.clear();
+	animations.clear();
+
+	std::ifstream file(descriptionPath);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open sprite atlas: " << toUtf8(descriptionPath) << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		std::istringstream stream(line);
+		std::string key;
+		if (!(stream >> key) || key[0] == '#')
+		{
+			continue;
+		}
+
+		if (key == "image")
+		{
+			// Relative to description file, decoded from UTF-8 so non-ASCII names survive
+			std::string path;
+			stream >> path;
+			imagePath = (descriptionPath.parent_path() / std::u8string(path.begin(), path.end())).wstring();
+			continue;
+		}
+
+		Animation animation;
+		animation.name = key;
+
+		int frameCount;
+		float x, y, w, h;
+		if (!(stream >> frameCount >> animation.fps >> x >> y >> w >> h) ||
+			frameCount <= 0 || frameCount > MAX_FRAMES_PER_ANIMATION || animation.fps < 0.0f || w <= 0.0f || h <= 0.0f)
+		{
+			std::cout << "Bad sprite atlas entry at line " << lineNumber << std::endl;
+			animations.clear();
+			return false;
+		}
+
+		animation.frameCount = (size_t)frameCount;
+		animation.firstFrame = frames.size();
+		for (size_t i = 0; i < animation.frameCount; i++)
+		{
+			frames.push_back({ x + w * i, y, w, h });
+		}
+
+		animations.push_back(animation);
+	}
+
+	if (imagePath.empty() || animations.empty())
+	{
+		std::cout << "Sprite atlas has no image or animations: " << toUtf8(descriptionPath) << std::endl;
+		animations.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool SpriteAtlas::isLoaded() const
+{
+	return !animations.empty();
+}
+
+const std::wstring& SpriteAtlas::getImagePath() const
+{
+	return imagePath;
+}
+
+int SpriteAtlas::getAnimationIndex(const std::string& name) const
+{
+	for (size_t i = 0; i < animations.size(); i++)
+	{
+		if (animations[i].name == name)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+const SpriteAtlas::Frame& SpriteAtlas::getFrame(int animationIndex, float time) const
+{
+	const Animation& animation = animations[animationIndex];
+
+	size_t frame = (size_t)(time * animation.fps) % animation.frameCount;
+	return frames[animation.firstFrame + frame];
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Description of an atlas image packed offline
+// Text format in UTF-8, one entry per line ('#' starts a comment):
+//   image <path relative to description file>
+//   <animation name> <frame count> <fps> <x> <y> <frame width> <frame height>
+// Frames of an animation are laid out left to right starting at (x, y).
+class SpriteAtlas
+{
+public:
+	struct Frame
+	{
+		float x, y, w, h;
+	};
+
+	bool load(const std::filesystem::path& descriptionPath);
+	bool isLoaded() const;
+
+	const std::wstring& getImagePath() const;
+
+	// Returns -1 if atlas has no such animation
+	int getAnimationIndex(const std::string& name) const;
+
+	// Looping playback
+	const Frame& getFrame(int animationIndex, float time) const;
+private:
+	struct Animation
+	{
+		std::string name;
+		size_t firstFrame = 0;
+		size_t frameCount = 0;
+		float fps = 0.0f;
+	};
+
+	std::wstring imagePath;
+
+	// Source rectangles of every frame, precomputed on load
+	std::vector<Frame> frames;
+	std::vector<Animation> animations;
+};
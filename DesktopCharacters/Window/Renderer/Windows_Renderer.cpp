@@ -2,9 +2,25 @@
 
 #include <stdexcept>
 
+// Text layouts not drawn for this many frames are released
+static const uint64_t TEXT_LAYOUT_MAX_AGE = 120;
+static const uint64_t TEXT_LAYOUT_EVICTION_PERIOD = 60;
+
+template<typename T>
+static void safeRelease(T*& object)
+{
+    if (object)
+    {
+        object->Release();
+        object = nullptr;
+    }
+}
+
 Windows_Renderer::Windows_Renderer(HWND hwnd) :
-    hwnd(hwnd), factory(nullptr), renderTarget(nullptr),
-    dwriteFactory(nullptr), textFormat(nullptr)
+    hwnd(hwnd), factory(nullptr), renderTarget(nullptr), brush(nullptr),
+    dwriteFactory(nullptr), frameIndex(0),
+    wicFactory(nullptr), atlasPixels(nullptr), atlasBitmap(nullptr),
+    deviceContext(nullptr), spriteBatch(nullptr)
 {
     // Direct 2D
     D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &factory);
@@ -17,25 +33,23 @@ Windows_Renderer::Windows_Renderer(HWND hwnd) :
     );
 
     // Default text format
-    if (dwriteFactory)
-    {
-        dwriteFactory->CreateTextFormat(
-            L"Segoe UI",                // Font family
-            nullptr,                    // Font collection
-            DWRITE_FONT_WEIGHT_NORMAL,
-            DWRITE_FONT_STYLE_NORMAL,
-            DWRITE_FONT_STRETCH_NORMAL,
-            48.0f,                      // Font size
-            L"en-us",                   // Locale
-            &textFormat
-        );
-    }
+    getTextFormat(48.0f);
 }
 
 Windows_Renderer::~Windows_Renderer()
 {
     discardResources();
-    if (textFormat) textFormat->Release();
+    for (auto& pair : textLayouts)
+    {
+        for (auto& cached : pair.second)
+        {
+            cached.layout->Release();
+        }
+    }
+    for (auto& pair : textFormats)
+    {
+        if (pair.second) pair.second->Release();
+    }
     if (dwriteFactory) dwriteFactory->Release();
     if (factory) factory->Release();
 }
@@ -61,6 +75,12 @@ void Windows_Renderer::afterRender()
     {
         throw std::runtime_error("RenderTarget->EndDraw failed");
     }
+
+    frameIndex++;
+    if (frameIndex % TEXT_LAYOUT_EVICTION_PERIOD == 0)
+    {
+        evictTextLayouts();
+    }
 }
 
 void Windows_Renderer::createResources()
@@ -101,6 +121,15 @@ void Windows_Renderer::createResources()
     if (FAILED(hr)) {
         throw std::runtime_error("Failed to create brush");
     }
+
+    // Sprite batches need Direct2D 1.3, otherwise sprites are drawn one by one
+    if (SUCCEEDED(renderTarget->QueryInterface(IID_PPV_ARGS(&deviceContext))))
+    {
+        if (FAILED(deviceContext->CreateSpriteBatch(&spriteBatch)))
+        {
+            safeRelease(deviceContext);
+        }
+    }
 }
 
 void Windows_Renderer::discardResources()
@@ -115,6 +144,9 @@ void Windows_Renderer::discardResources()
         brush->Release();
         brush = nullptr;
     }
+    safeRelease(atlasBitmap);
+    safeRelease(spriteBatch);
+    safeRelease(deviceContext);
 }
 
 void Windows_Renderer::drawRectangle(float x, float y, float w, float h, const Color& color, float strokeWidth)
@@ -171,19 +203,263 @@ void Windows_Renderer::drawLine(float x1, float y1, float x2, float y2, const Co
     );
 }
 
-void Windows_Renderer::drawText(const std::wstring& text, float x, float y, float w, float h, const Color& color)
+void Windows_Renderer::drawText(const std::wstring& text, float x, float y, float w, float h, const Color& color, float fontSize)
 {
-    if (!renderTarget || !brush || !textFormat) return;
+    if (!renderTarget || !brush || text.empty()) return;
+
+    IDWriteTextLayout* layout = getTextLayout(text, fontSize, w, h);
+    if (!layout) return;
 
     brush->SetColor({ color.r, color.g, color.b, color.a });
 
-    D2D1_RECT_F layoutRect = D2D1::RectF(x, y, x + w, y + h);
+    renderTarget->DrawTextLayout(D2D1::Point2F(x, y), layout, brush);
+}
 
-    renderTarget->DrawTextW(
+// One format per font size, created on first use
+IDWriteTextFormat* Windows_Renderer::getTextFormat(float fontSize)
+{
+    auto it = textFormats.find(fontSize);
+    if (it != textFormats.end())
+    {
+        return it->second;
+    }
+
+    IDWriteTextFormat* format = nullptr;
+    if (dwriteFactory)
+    {
+        dwriteFactory->CreateTextFormat(
+            L"Segoe UI",                // Font family
+            nullptr,                    // Font collection
+            DWRITE_FONT_WEIGHT_NORMAL,
+            DWRITE_FONT_STYLE_NORMAL,
+            DWRITE_FONT_STRETCH_NORMAL,
+            fontSize,                   // Font size
+            L"en-us",                   // Locale
+            &format
+        );
+    }
+
+    // Failures are cached too, so they aren't retried every frame
+    textFormats[fontSize] = format;
+    return format;
+}
+
+// Returns shaped layout of the text, shaping it only if it isn't cached yet
+IDWriteTextLayout* Windows_Renderer::getTextLayout(const std::wstring& text, float fontSize, float maxWidth, float maxHeight)
+{
+    auto found = textLayouts.find(text);
+    if (found != textLayouts.end())
+    {
+        for (auto& cached : found->second)
+        {
+            if (cached.fontSize == fontSize && cached.maxWidth == maxWidth && cached.maxHeight == maxHeight)
+            {
+                cached.lastUsedFrame = frameIndex;
+                return cached.layout;
+            }
+        }
+    }
+
+    IDWriteTextFormat* format = getTextFormat(fontSize);
+    if (!format) return nullptr;
+
+    IDWriteTextLayout* layout = nullptr;
+    HRESULT hr = dwriteFactory->CreateTextLayout(
         text.c_str(),
         static_cast<UINT32>(text.length()),
-        textFormat,
-        &layoutRect,
-        brush
+        format,
+        maxWidth,
+        maxHeight,
+        &layout
+    );
+    if (FAILED(hr)) return nullptr;
+
+    // Entry is added only for a created layout, failed texts don't leave empty entries behind
+    if (found == textLayouts.end())
+    {
+        found = textLayouts.emplace(text, std::vector<CachedTextLayout>()).first;
+    }
+    found->second.push_back({ layout, fontSize, maxWidth, maxHeight, frameIndex });
+
+    return layout;
+}
+
+void Windows_Renderer::evictTextLayouts()
+{
+    for (auto it = textLayouts.begin(); it != textLayouts.end();)
+    {
+        auto& variants = it->second;
+        for (size_t i = 0; i < variants.size();)
+        {
+            if (frameIndex - variants[i].lastUsedFrame > TEXT_LAYOUT_MAX_AGE)
+            {
+                variants[i].layout->Release();
+                variants[i] = variants.back();
+                variants.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        if (variants.empty())
+        {
+            it = textLayouts.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+bool Windows_Renderer::loadSpriteAtlas(const std::wstring& imagePath)
+{
+    if (!wicFactory)
+    {
+        HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&wicFactory));
+        if (FAILED(hr))
+        {
+            return false;
+        }
+    }
+
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = nullptr;
+    IWICFormatConverter* converter = nullptr;
+    IWICBitmap* pixels = nullptr;
+
+    HRESULT hr = wicFactory->CreateDecoderFromFilename(imagePath.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnLoad, &decoder);
+    if (SUCCEEDED(hr))
+    {
+        hr = decoder->GetFrame(0, &frame);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = wicFactory->CreateFormatConverter(&converter);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = converter->Initialize(frame, GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeMedianCut);
+    }
+    if (SUCCEEDED(hr))
+    {
+        // Decode whole image now, so device copies can be made without touching the file again
+        hr = wicFactory->CreateBitmapFromSource(converter, WICBitmapCacheOnLoad, &pixels);
+    }
+
+    safeRelease(converter);
+    safeRelease(frame);
+    safeRelease(decoder);
+
+    if (FAILED(hr))
+    {
+        return false;
+    }
+
+    safeRelease(atlasPixels);
+    safeRelease(atlasBitmap);
+    atlasPixels = pixels;
+
+    return true;
+}
+
+void Windows_Renderer::releaseSpriteAtlas()
+{
+    safeRelease(atlasPixels);
+    safeRelease(wicFactory);
+}
+
+bool Windows_Renderer::hasSpriteAtlas() const
+{
+    return atlasPixels != nullptr;
+}
+
+void Windows_Renderer::drawSprites(const std::vector<Sprite>& sprites)
+{
+    if (!renderTarget || !atlasPixels || sprites.empty()) return;
+
+    if (!atlasBitmap)
+    {
+        if (FAILED(renderTarget->CreateBitmapFromWicBitmap(atlasPixels, nullptr, &atlasBitmap)))
+        {
+            return;
+        }
+    }
+
+    if (!spriteBatch)
+    {
+        drawSpritesOneByOne(sprites);
+        return;
+    }
+
+    const size_t count = sprites.size();
+    spriteDestinations.resize(count);
+    spriteSources.resize(count);
+    spriteTransforms.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const Sprite& sprite = sprites[i];
+
+        spriteDestinations[i] = D2D1::RectF(sprite.x, sprite.y, sprite.x + sprite.w, sprite.y + sprite.h);
+        spriteSources[i] = D2D1::RectU(
+            (UINT32)sprite.srcX, (UINT32)sprite.srcY,
+            (UINT32)(sprite.srcX + sprite.srcW), (UINT32)(sprite.srcY + sprite.srcH));
+
+        if (sprite.flipX)
+        {
+            D2D1_POINT_2F center = D2D1::Point2F(sprite.x + sprite.w * 0.5f, sprite.y + sprite.h * 0.5f);
+            spriteTransforms[i] = D2D1::Matrix3x2F::Scale(-1.0f, 1.0f, center);
+        }
+        else
+        {
+            spriteTransforms[i] = D2D1::Matrix3x2F::Identity();
+        }
+    }
+
+    spriteBatch->Clear();
+    spriteBatch->AddSprites(
+        (UINT32)count,
+        spriteDestinations.data(),
+        spriteSources.data(),
+        nullptr,
+        spriteTransforms.data(),
+        sizeof(D2D1_RECT_F),
+        sizeof(D2D1_RECT_U),
+        0,
+        sizeof(D2D1_MATRIX_3X2_F)
     );
+
+    // Sprite batches are only drawn in aliased mode
+    D2D1_ANTIALIAS_MODE oldMode = deviceContext->GetAntialiasMode();
+    deviceContext->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+    deviceContext->DrawSpriteBatch(spriteBatch, atlasBitmap, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, D2D1_SPRITE_OPTIONS_NONE);
+    deviceContext->SetAntialiasMode(oldMode);
+}
+
+void Windows_Renderer::drawSpritesOneByOne(const std::vector<Sprite>& sprites)
+{
+    D2D1_MATRIX_3X2_F oldTransform;
+    renderTarget->GetTransform(&oldTransform);
+
+    for (const Sprite& sprite : sprites)
+    {
+        D2D1_RECT_F destination = D2D1::RectF(sprite.x, sprite.y, sprite.x + sprite.w, sprite.y + sprite.h);
+        D2D1_RECT_F source = D2D1::RectF(sprite.srcX, sprite.srcY, sprite.srcX + sprite.srcW, sprite.srcY + sprite.srcH);
+
+        if (sprite.flipX)
+        {
+            D2D1_POINT_2F center = D2D1::Point2F(sprite.x + sprite.w * 0.5f, sprite.y + sprite.h * 0.5f);
+            renderTarget->SetTransform(D2D1::Matrix3x2F::Scale(-1.0f, 1.0f, center));
+        }
+
+        renderTarget->DrawBitmap(atlasBitmap, destination, 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, source);
+
+        if (sprite.flipX)
+        {
+            renderTarget->SetTransform(oldTransform);
+        }
+    }
 }
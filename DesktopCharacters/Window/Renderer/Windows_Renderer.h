@@ -3,9 +3,16 @@
 
 #include <windows.h>
 #include <d2d1.h>
+#include <d2d1_3.h>
 #pragma comment(lib, "d2d1")
 #include <dwrite.h>
 #pragma comment(lib, "dwrite.lib")
+#include <wincodec.h>
+#pragma comment(lib, "windowscodecs.lib")
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 class Windows_Renderer : public BaseRenderer
 {
@@ -22,7 +29,12 @@ public:
 
     void drawLine(float x1, float y1, float x2, float y2, const Color& color, float strokeWidth = 2.0f) override;
 
-    void drawText(const std::wstring& text, float x, float y, float w, float h, const Color& color) override;
+    void drawText(const std::wstring& text, float x, float y, float w, float h, const Color& color, float fontSize = 48.0f) override;
+
+    bool loadSpriteAtlas(const std::wstring& imagePath) override;
+    void releaseSpriteAtlas() override;
+    bool hasSpriteAtlas() const override;
+    void drawSprites(const std::vector<Sprite>& sprites) override;
 
 private:
     void createResources();
@@ -35,5 +47,36 @@ private:
     ID2D1SolidColorBrush* brush;
 
     IDWriteFactory* dwriteFactory;
-    IDWriteTextFormat* textFormat;
+
+    // Text
+    // Shaped layouts are kept while they keep being drawn, so static labels aren't reshaped every frame
+    struct CachedTextLayout
+    {
+        IDWriteTextLayout* layout;
+        float fontSize;
+        float maxWidth, maxHeight;
+        uint64_t lastUsedFrame;
+    };
+
+    std::unordered_map<float, IDWriteTextFormat*> textFormats;
+    std::unordered_map<std::wstring, std::vector<CachedTextLayout>> textLayouts;
+    uint64_t frameIndex;
+
+    IDWriteTextFormat* getTextFormat(float fontSize);
+    IDWriteTextLayout* getTextLayout(const std::wstring& text, float fontSize, float maxWidth, float maxHeight);
+    void evictTextLayouts();
+
+    // Sprites
+    IWICImagingFactory* wicFactory;     // Created in the COM apartment of the thread loading the atlas
+    IWICBitmap* atlasPixels;             // Decoded atlas, survives device loss
+    ID2D1Bitmap* atlasBitmap;            // Device copy of atlasPixels
+    ID2D1DeviceContext3* deviceContext;  // Null if Direct2D 1.3 isn't available
+    ID2D1SpriteBatch* spriteBatch;
+
+    // Reused between frames
+    std::vector<D2D1_RECT_F> spriteDestinations;
+    std::vector<D2D1_RECT_U> spriteSources;
+    std::vector<D2D1_MATRIX_3X2_F> spriteTransforms;
+
+    void drawSpritesOneByOne(const std::vector<Sprite>& sprites);
 };
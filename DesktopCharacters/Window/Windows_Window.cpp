@@ -109,6 +109,18 @@ bool Windows_Window::createWindow(const InitWindowParams& params)
         SetLayeredWindowAttributes(hwnd, RGB(0, 0, 0), 0, LWA_COLORKEY);
     }
 
+    // Raw mouse input arrives for every device report, even when window is not under cursor
+    RAWINPUTDEVICE mouseDevice = {};
+    mouseDevice.usUsagePage = 0x01; // Generic desktop
+    mouseDevice.usUsage = 0x02;     // Mouse
+    mouseDevice.dwFlags = RIDEV_INPUTSINK;
+    mouseDevice.hwndTarget = hwnd;
+    if (!RegisterRawInputDevices(&mouseDevice, 1, sizeof(mouseDevice)))
+    {
+        DWORD error = GetLastError();
+        std::cout << "RegisterRawInputDevices failed with error: " << error << std::endl;
+    }
+
     ShowWindow(hwnd, SW_SHOW);
     UpdateWindow(hwnd);
 
@@ -165,7 +177,7 @@ LRESULT CALLBACK Windows_Window::windowProc(HWND hwnd, UINT msg, WPARAM wParam,
 // Instance method handling messages
 LRESULT Windows_Window::handleMessage(UINT msg, WPARAM wParam, LPARAM lParam)
 {
-    if (callback)
+    if (eventQueue)
     {
         WindowEvent evt;
 
@@ -197,8 +209,26 @@ LRESULT Windows_Window::handleMessage(UINT msg, WPARAM wParam, LPARAM lParam)
             evt.type = WindowEvent::Type::MouseMove;
             evt.localMouseX = GET_X_LPARAM(lParam);
             evt.localMouseY = GET_Y_LPARAM(lParam);
+
+            // Real cursor position, raw deltas continue from here
+            rawCursor = { evt.localMouseX, evt.localMouseY };
+            rawCursorValid = true;
             break;
 
+        case WM_INPUT:
+        {
+            RAWINPUT input;
+            UINT size = sizeof(input);
+            if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &input, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1 &&
+                input.header.dwType == RIM_TYPEMOUSE && readRawMouse(input.data.mouse))
+            {
+                evt.type = WindowEvent::Type::MouseMove;
+                evt.localMouseX = rawCursor.x;
+                evt.localMouseY = rawCursor.y;
+            }
+            break;
+        }
+
         case WM_KEYDOWN:
             evt.type = WindowEvent::Type::KeyDown;
             evt.keyCode = static_cast<int>(wParam);
@@ -211,8 +241,47 @@ LRESULT Windows_Window::handleMessage(UINT msg, WPARAM wParam, LPARAM lParam)
         }
 
         if (evt.type != WindowEvent::Type::None)
-            callback(evt);
+            pushEvent(evt);
     }
 
     return DefWindowProc(hwnd, msg, wParam, lParam);
-}
\ No newline at end of file
+}
+
+// Moves raw cursor by one device report, false if the report has no movement
+// Absolute devices (tablets, remote desktop) report a position normalized to 0..65535,
+// relative ones a delta that is applied to the last known cursor position
+bool Windows_Window::readRawMouse(const RAWMOUSE& mouse)
+{
+    if (mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+    {
+        const bool virtualDesktop = (mouse.usFlags & MOUSE_VIRTUAL_DESKTOP) != 0;
+        const int left = virtualDesktop ? GetSystemMetrics(SM_XVIRTUALSCREEN) : 0;
+        const int top = virtualDesktop ? GetSystemMetrics(SM_YVIRTUALSCREEN) : 0;
+        const int width = GetSystemMetrics(virtualDesktop ? SM_CXVIRTUALSCREEN : SM_CXSCREEN);
+        const int height = GetSystemMetrics(virtualDesktop ? SM_CYVIRTUALSCREEN : SM_CYSCREEN);
+
+        POINT cursor = { left + MulDiv(mouse.lLastX, width - 1, 65535), top + MulDiv(mouse.lLastY, height - 1, 65535) };
+        ScreenToClient(hwnd, &cursor);
+        rawCursor = cursor;
+        rawCursorValid = true;
+        return true;
+    }
+
+    if (mouse.lLastX == 0 && mouse.lLastY == 0)
+    {
+        return false;
+    }
+
+    if (!rawCursorValid)
+    {
+        if (!GetCursorPos(&rawCursor) || !ScreenToClient(hwnd, &rawCursor))
+        {
+            return false;
+        }
+        rawCursorValid = true;
+    }
+
+    rawCursor.x += mouse.lLastX;
+    rawCursor.y += mouse.lLastY;
+    return true;
+}
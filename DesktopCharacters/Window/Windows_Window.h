@@ -33,4 +33,11 @@ private:
 
     // Instance method for handling messages
     LRESULT handleMessage(UINT msg, WPARAM wParam, LPARAM lParam);
+
+    // Cursor followed through raw input, in client coordinates
+    // Every WM_MOUSEMOVE puts it back on the real cursor, raw deltas skip pointer acceleration
+    POINT rawCursor = {};
+    bool rawCursorValid = false;
+
+    bool readRawMouse(const RAWMOUSE& mouse);
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "WorldSnapshot.h"
+
+#include <algorithm>
+
+static bool obstacleLess(const Obstacle& a, const Obstacle& b)
+{
+    if (a.type != b.type)
+    {
+        return a.type < b.type;
+    }
+    return a.perpOffset < b.perpOffset;
+}
+
+void WorldSnapshot::finalize()
+{
+    bounds = AABB(-size, size);
+
+    if (!std::is_sorted(obstacles.begin(), obstacles.end(), obstacleLess))
+    {
+        std::sort(obstacles.begin(), obstacles.end(), obstacleLess);
+    }
+
+    auto firstVertical = std::partition_point(obstacles.begin(), obstacles.end(),
+        [](const Obstacle& obstacle) { return obstacle.type == Obstacle::Type::Horizontal; });
+    verticalBegin = firstVertical - obstacles.begin();
+
+    if (!std::is_sorted(windowTops.begin(), windowTops.end(), obstacleLess))
+    {
+        std::sort(windowTops.begin(), windowTops.end(), obstacleLess);
+    }
+}
+
+void WorldSnapshot::getObstaclesInRange(Obstacle::Type type, float min, float max, const Obstacle*& begin, const Obstacle*& end) const
+{
+    const Obstacle* data = obstacles.data();
+    const Obstacle* typeBegin = type == Obstacle::Type::Horizontal ? data : data + verticalBegin;
+    const Obstacle* typeEnd = type == Obstacle::Type::Horizontal ? data + verticalBegin : data + obstacles.size();
+
+    begin = std::lower_bound(typeBegin, typeEnd, min,
+        [](const Obstacle& obstacle, float value) { return obstacle.perpOffset < value; });
+    end = std::upper_bound(begin, typeEnd, max,
+        [](float value, const Obstacle& obstacle) { return value < obstacle.perpOffset; });
+}
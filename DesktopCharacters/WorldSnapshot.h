@@ -0,0 +1,30 @@
+#pragma once
+#include "Core/AABB.h"
+#include "Core/Vec2.h"
+
+#include "Obstacle.h"
+
+#include <cstdint>
+#include <vector>
+
+// Everything characters collide with, never changed after publishing
+// Readers keep the shared_ptr they got for as long as they use it,
+// so a newer snapshot can be built and published meanwhile.
+struct WorldSnapshot
+{
+    uint64_t version = 0; // Grows with every rebuild
+
+    Vec2 size; // Half extents, center is at zero
+    AABB bounds;
+
+    std::vector<Obstacle> obstacles; // Sorted by type, then by perpOffset
+    size_t verticalBegin = 0; // Index of first vertical obstacle
+
+    std::vector<Obstacle> windowTops; // Visible parts of window top edges, sorted by perpOffset
+
+    // Sorts obstacles and fills lookup data, called once before publishing
+    void finalize();
+
+    // Obstacles of given type with perpOffset in [min, max], as [begin, end)
+    void getObstaclesInRange(Obstacle::Type type, float min, float max, const Obstacle*& begin, const Obstacle*& end) const;
+};
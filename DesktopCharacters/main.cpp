@@ -1,8 +1,10 @@
 #include "CharactersManager.h"
 
+#include "Core/Profiler.h"
 #include "Core/Random.h"
 
 #include <iostream>
+#include <sstream>
 
 static void openConsole()
 {
@@ -18,7 +20,64 @@ static void openConsole()
     std::cout << "Debug console is ready!" << std::endl;
 }
 
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
+// --capture <file> records desktop input, --replay <file> plays one back instead of the desktop,
+// starting --replay-start seconds in at --replay-speed times real time,
+// or with --replay-fixed-step one step per loop as fast as possible, same result on every run
+// --crowd <count> adds a crowd of lightweight bodies for stress displays
+// --strict-allocations aborts on first allocation in an allocation-free zone, in builds that track allocations
+static void parseCommandLine(const char* commandLine, CharactersManager& manager, int& crowdSize)
+{
+    std::string capturePath, replayPath;
+    double replayStart = 0.0, replaySpeed = 1.0;
+    bool replayFixedStep = false;
+
+    std::istringstream stream(commandLine);
+    std::string option;
+    while (stream >> option)
+    {
+        if (option == "--capture")
+        {
+            stream >> capturePath;
+        }
+        else if (option == "--replay")
+        {
+            stream >> replayPath;
+        }
+        else if (option == "--replay-start")
+        {
+            stream >> replayStart;
+        }
+        else if (option == "--replay-speed")
+        {
+            stream >> replaySpeed;
+        }
+        else if (option == "--replay-fixed-step")
+        {
+            replayFixedStep = true;
+        }
+        else if (option == "--crowd")
+        {
+            stream >> crowdSize;
+        }
+        else if (option == "--strict-allocations")
+        {
+#ifdef PROFILE_ALLOCATIONS
+            Profiler::setStrictAllocations(true);
+#else
+            std::cout << "--strict-allocations needs a build with PROFILE_ALLOCATIONS" << std::endl;
+#endif
+        }
+        else
+        {
+            std::cout << "Unknown option: " << option << std::endl;
+        }
+    }
+
+    manager.setCapturePath(capturePath);
+    manager.setReplay(replayPath, replayStart, replaySpeed, replayFixedStep);
+}
+
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int)
 {
 #ifdef _DEBUG
     openConsole();
@@ -27,12 +86,16 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
     // Create the characters manager
     CharactersManager manager;
+    int crowdSize = 0;
+    parseCommandLine(commandLine, manager, crowdSize);
     if (!manager.initialize())
     {
         return -1;
     }
 
-    // Create characters
+    manager.setCharacterCollisionsEnabled(true);
+
+    // Create characters, unless previous run left them saved
     Character::Data charData;
 
     charData.maxSpeed = 1.5f;
@@ -42,9 +105,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     charData.collisionElasticityRoof = 0.2f;
     charData.collisionElasticityFloor = 0.0f;
 
-    charData.frictionFloor = 0.4f;
+    charData.frictionFloor = 24.0f;
+
+    const bool restored = manager.restoreState();
 
-    for (int i = 0; i < 1; i++)
+    for (int i = 0; !restored && i < 1; i++)
     {
         float x = Random::Float(-1.0f, 1.0f);
         float y = Random::Float(-1.0f, 1.0f);
@@ -57,6 +122,28 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         }
     }
 
+    // Crowd for stress displays, restored state brings its own
+    if (!restored && crowdSize > 0)
+    {
+        Crowd::Data crowdData;
+        crowdData.bodySize = Vec2(0.05f, 0.05f);
+        crowdData.collisionElasticitySides = 0.2f;
+        crowdData.collisionElasticityRoof = 0.2f;
+        crowdData.frictionFloor = 24.0f;
+
+        manager.enableCrowd(crowdData);
+    }
+
+    for (int i = 0; !restored && i < crowdSize; i++)
+    {
+        float x = Random::Float(-2.0f, 2.0f);
+        float y = Random::Float(-1.0f, 1.0f);
+        float vx = Random::Float(-1.0f, 1.0f);
+        float vy = Random::Float(-1.0f, 1.0f);
+
+        manager.addCrowdBody({ x, y }, { vx, vy });
+    }
+
     // Run the message loop - manager will handle all windows
     int result = manager.runLoop();
 
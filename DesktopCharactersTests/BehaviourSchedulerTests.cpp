@@ -0,0 +1,122 @@
+#include "Tests.h"
+
+#include "BehaviourScheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct Resumed
+{
+    uint32_t index;
+    uint64_t tick;
+};
+
+// Seconds that round up to exactly steps ticks
+static float stepsToSeconds(uint32_t steps)
+{
+    return ((float)steps - 0.5f) * BehaviourScheduler::STEP_TIME;
+}
+
+static Behaviour waitThenRecord(BehaviourScheduler* scheduler, uint32_t index, uint32_t steps, const uint64_t* tick, std::vector<Resumed>* resumed)
+{
+    co_await scheduler->waitSeconds(index, stepsToSeconds(steps));
+    resumed->push_back({ index, *tick });
+}
+
+// Sets flag when the coroutine frame holding it is destroyed
+struct DestroyFlag
+{
+    bool* destroyed;
+    ~DestroyFlag() { *destroyed = true; }
+};
+
+static Behaviour waitLong(BehaviourScheduler* scheduler, uint32_t index, bool* destroyed)
+{
+    DestroyFlag flag{ destroyed };
+    co_await scheduler->waitSeconds(index, 100.0f);
+}
+
+static Behaviour awaitChild(BehaviourScheduler* scheduler, uint32_t index, bool* destroyed, bool* childDestroyed, bool* finished)
+{
+    DestroyFlag flag{ destroyed };
+    co_await waitLong(scheduler, index, childDestroyed);
+    *finished = true;
+}
+
+TEST(timerWheelResumesInDeadlineOrder)
+{
+    // Several deadlines share a slot, some are more than a turn of the wheel away
+    const std::vector<uint32_t> steps = { 600, 3, 256, 257, 1, 100, 3, 512, 855 };
+
+    BehaviourScheduler scheduler;
+    uint64_t tick = 0;
+    std::vector<Resumed> resumed;
+    for (uint32_t i = 0; i < (uint32_t)steps.size(); i++)
+    {
+        scheduler.start(i, waitThenRecord(&scheduler, i, steps[i], &tick, &resumed));
+    }
+    CHECK(resumed.empty());
+
+    for (tick = 1; tick <= 1000; tick++)
+    {
+        scheduler.tick();
+    }
+
+    CHECK(resumed.size() == steps.size());
+    for (const Resumed& entry : resumed)
+    {
+        CHECK(entry.tick == steps[entry.index]);
+    }
+    CHECK(std::is_sorted(resumed.begin(), resumed.end(),
+        [](const Resumed& a, const Resumed& b) { return a.tick < b.tick; }));
+}
+
+TEST(restartedBehaviourLeavesTimerWheel)
+{
+    BehaviourScheduler scheduler;
+    uint64_t tick = 0;
+    std::vector<Resumed> resumed;
+    scheduler.start(0, waitThenRecord(&scheduler, 0, 10, &tick, &resumed));
+    scheduler.start(1, waitThenRecord(&scheduler, 1, 10, &tick, &resumed));
+
+    // Replaced before its deadline, only the new wait may resume
+    scheduler.start(0, waitThenRecord(&scheduler, 0, 20, &tick, &resumed));
+
+    for (tick = 1; tick <= 30; tick++)
+    {
+        scheduler.tick();
+    }
+
+    CHECK(resumed.size() == 2 && resumed[0].index == 1 && resumed[0].tick == 10);
+    CHECK(resumed.size() == 2 && resumed[1].index == 0 && resumed[1].tick == 20);
+}
+
+TEST(suspendedBehavioursAreDestroyed)
+{
+    BehaviourScheduler scheduler;
+
+    // Restart destroys the suspended behaviour and the child it awaits
+    bool destroyed = false, childDestroyed = false, finished = false;
+    scheduler.start(0, awaitChild(&scheduler, 0, &destroyed, &childDestroyed, &finished));
+    CHECK(!destroyed && !childDestroyed);
+
+    bool otherDestroyed = false, otherChildDestroyed = false, otherFinished = false;
+    scheduler.start(0, awaitChild(&scheduler, 0, &otherDestroyed, &otherChildDestroyed, &otherFinished));
+    CHECK(destroyed && childDestroyed);
+    CHECK(!otherDestroyed && !otherChildDestroyed);
+
+    // So does clear()
+    scheduler.clear();
+    CHECK(otherDestroyed && otherChildDestroyed);
+
+    // Destroyed waits never resume
+    const uint64_t resumedCount = scheduler.getResumedCount();
+    for (int i = 0; i < 7000; i++)
+    {
+        scheduler.tick();
+    }
+    CHECK(scheduler.getResumedCount() == resumedCount);
+    CHECK(!finished && !otherFinished);
+}
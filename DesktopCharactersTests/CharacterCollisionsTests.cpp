@@ -0,0 +1,113 @@
+#include "Tests.h"
+
+#include "CharacterCollisions.h"
+#include "Core/Random.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static const Vec2 CHARACTER_SIZE(0.05f, 0.05f);
+
+static std::unique_ptr<Character> makeCharacter(const Vec2& position)
+{
+    Character::Data data;
+    data.maxSpeed = 0.5f;
+    data.maxJumpVelocity = 3.0f;
+    data.frictionFloor = 120.0f;
+
+    auto character = std::make_unique<Character>(position, CHARACTER_SIZE, data);
+    character->updateAABB();
+    return character;
+}
+
+// Floor at y = -1 and a window side at x = 0
+static WorldSnapshot makeWallWorld()
+{
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Vertical, 0.0f, -1.0f, 1.0f);
+    world.finalize();
+    return world;
+}
+
+TEST(pushDoesNotCrossWindowSide)
+{
+    const WorldSnapshot world = makeWallWorld();
+    const float halfWidth = CHARACTER_SIZE.x * 0.5f;
+
+    // Right character touches the wall, left one overlaps it by half its width
+    std::vector<std::unique_ptr<Character>> characters;
+    characters.push_back(makeCharacter(Vec2(-halfWidth, -1.0f + halfWidth)));
+    characters.push_back(makeCharacter(Vec2(-halfWidth * 2.0f, -1.0f + halfWidth)));
+
+    CharacterCollisions collisions;
+    collisions.resolve(characters, world);
+
+    CHECK(collisions.getContactsCount() == 1);
+    CHECK(characters[0]->getAABB().maxX <= 0.0f);
+
+    // Later steps must not start behind the wall either
+    characters[0]->setVelocity(2.0f, 0.0f);
+    for (int i = 0; i < 30; i++)
+    {
+        characters[0]->update(1.0f / 60.0f, world);
+        collisions.resolve(characters, world);
+        CHECK(characters[0]->getAABB().maxX <= 1e-5f);
+    }
+}
+
+TEST(separatesOverlappingCharacters)
+{
+    const WorldSnapshot world = makeWallWorld();
+
+    std::vector<std::unique_ptr<Character>> characters;
+    characters.push_back(makeCharacter(Vec2(-0.5f, 0.0f)));
+    characters.push_back(makeCharacter(Vec2(-0.49f, 0.0f)));
+
+    CharacterCollisions collisions;
+    collisions.resolve(characters, world);
+
+    const float gap = characters[1]->getAABB().minX - characters[0]->getAABB().maxX;
+    CHECK(fabsf(gap) < 1e-5f);
+}
+
+// Characters scattered over an area growing with their count, so density stays the same
+BENCHMARK(characterCollisionsResolve)
+{
+    WorldSnapshot world;
+    world.size = Vec2(1000.0f, 1000.0f);
+    world.finalize();
+
+    for (int count : { 1000, 10000, 50000 })
+    {
+        const float extent = sqrtf((float)count) * CHARACTER_SIZE.x;
+
+        std::vector<std::unique_ptr<Character>> characters;
+        for (int i = 0; i < count; i++)
+        {
+            characters.push_back(makeCharacter(Vec2(Random::Float(-extent, extent), Random::Float(-extent, extent))));
+        }
+
+        CharacterCollisions collisions;
+        collisions.resolve(characters, world); // First call sizes the grid
+
+        // Jitter between steps isn't part of the measured time
+        const int steps = 20;
+        double milliseconds = 0.0;
+        for (int step = 0; step < steps; step++)
+        {
+            for (auto& character : characters)
+            {
+                character->move(Random::Float(-1e-3f, 1e-3f), 0.0f);
+                character->updateAABB();
+            }
+            milliseconds += Tests::measure(1, [&]() { collisions.resolve(characters, world); }) / steps;
+        }
+
+        std::cout << "        " << count << " characters: " << milliseconds << " ms per step, "
+            << collisions.getCandidatePairsCount() << " candidate pairs" << std::endl;
+    }
+}
@@ -0,0 +1,52 @@
+#include "Tests.h"
+
+#include "CharacterLOD.h"
+
+#include <memory>
+#include <vector>
+
+static void addCharacters(std::vector<std::unique_ptr<Character>>& characters, size_t count, float x)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        auto character = std::make_unique<Character>(Vec2(x, 0.0f), Vec2(0.05f, 0.05f), Character::Data());
+        character->updateAABB();
+        characters.push_back(std::move(character));
+    }
+}
+
+TEST(lodReschedulesWhenCharactersRemoved)
+{
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.finalize();
+
+    // Off screen, so everyone drops to the low tier
+    std::vector<std::unique_ptr<Character>> characters;
+    addCharacters(characters, 100, 10.0f);
+
+    CharacterLOD lod;
+    for (int i = 0; i < 8; i++)
+    {
+        lod.schedule(characters, world, Vec2(), 1.0f / 60.0f);
+    }
+    CHECK(lod.getTierCount(CharacterLOD::Tier::Low) == 100);
+
+    characters.clear();
+    addCharacters(characters, 10, 10.0f);
+
+    size_t dueCount = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        lod.schedule(characters, world, Vec2(), 1.0f / 60.0f);
+        for (uint32_t index : lod.getDue())
+        {
+            CHECK(index < characters.size());
+        }
+        dueCount += lod.getDue().size();
+    }
+
+    // Every character is due right away, then once more after the low tier's period
+    CHECK(dueCount == 20);
+    CHECK(lod.getTierCount(CharacterLOD::Tier::Low) == 10);
+}
@@ -0,0 +1,80 @@
+#include "Tests.h"
+
+#include "Character.h"
+#include "Core/Random.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static const float STEP_TIME = 1.0f / 60.0f;
+
+// Screen edges of a 2 x 1 world and a dozen overlapping windows, four edges each
+static WorldSnapshot makeDesktopWorld()
+{
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, 1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Vertical, -2.0f, -1.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Vertical, 2.0f, -1.0f, 1.0f);
+
+    for (int i = 0; i < 12; i++)
+    {
+        const float minX = -1.8f + 0.28f * i;
+        const float minY = -0.8f + 0.11f * (i % 5);
+        const AABB window(minX, minY, minX + 0.6f, minY + 0.5f);
+
+        world.obstacles.emplace_back(Obstacle::Type::Horizontal, window.maxY, window.minX, window.maxX);
+        world.obstacles.emplace_back(Obstacle::Type::Horizontal, window.minY, window.minX, window.maxX);
+        world.obstacles.emplace_back(Obstacle::Type::Vertical, window.minX, window.minY, window.maxY);
+        world.obstacles.emplace_back(Obstacle::Type::Vertical, window.maxX, window.minY, window.maxY);
+        world.windowTops.emplace_back(Obstacle::Type::Horizontal, window.maxY, window.minX, window.maxX);
+    }
+    world.finalize();
+    return world;
+}
+
+// Walking and falling characters, the path every simulation step takes through Vec2 and AABB math
+BENCHMARK(characterUpdate)
+{
+    const WorldSnapshot world = makeDesktopWorld();
+
+    Character::Data data;
+    data.maxSpeed = 0.5f;
+    data.maxJumpVelocity = 3.0f;
+    data.frictionFloor = 120.0f;
+
+    for (int count : { 1000, 10000 })
+    {
+        std::vector<std::unique_ptr<Character>> characters;
+        for (int i = 0; i < count; i++)
+        {
+            auto character = std::make_unique<Character>(Vec2(Random::Float(-1.9f, 1.9f), Random::Float(-0.9f, 0.9f)), Vec2(0.05f, 0.05f), data);
+            character->updateAABB();
+            characters.push_back(std::move(character));
+        }
+
+        // Characters are kicked again every few steps so they don't all come to rest
+        const int steps = 120;
+        double milliseconds = 0.0;
+        for (int step = 0; step < steps; step++)
+        {
+            if (step % 30 == 0)
+            {
+                for (auto& character : characters)
+                {
+                    character->setVelocity(Random::Float(-2.0f, 2.0f), Random::Float(-1.0f, 3.0f));
+                }
+            }
+            milliseconds += Tests::measure(1, [&]() {
+                for (auto& character : characters)
+                {
+                    character->update(STEP_TIME, world);
+                }
+                }) / steps;
+        }
+
+        std::cout << "        " << count << " characters: " << milliseconds << " ms per step" << std::endl;
+    }
+}
@@ -0,0 +1,95 @@
+#include "Tests.h"
+
+#include "Crowd.h"
+#include "Core/Random.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const float STEP_TIME = 1.0f / 60.0f;
+
+// Floor, roof and walls of a 2 x 1 world plus a window in the middle
+static WorldSnapshot makeBoxWorld()
+{
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, 1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, 0.2f, -0.5f, 0.5f);
+    world.obstacles.emplace_back(Obstacle::Type::Vertical, -2.0f, -1.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Vertical, 2.0f, -1.0f, 1.0f);
+    world.finalize();
+    return world;
+}
+
+static void fillCrowd(Crowd& crowd, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        crowd.addBody(Vec2(Random::Float(-1.9f, 1.9f), Random::Float(-0.9f, 0.9f)), Vec2(Random::Float(-1.0f, 1.0f), Random::Float(-1.0f, 1.0f)));
+    }
+}
+
+// Ranges are independent, so splitting them across the pool must not change anything
+TEST(crowdThreadsMatchSingleThread)
+{
+    const WorldSnapshot world = makeBoxWorld();
+
+    Crowd single, pooled;
+    pooled.setThreadCount(4);
+
+    const std::string state = Random::GetState();
+    fillCrowd(single, 70000);
+    Random::SetState(state);
+    fillCrowd(pooled, 70000);
+
+    for (int step = 0; step < 20; step++)
+    {
+        single.update(STEP_TIME, world);
+        pooled.update(STEP_TIME, world);
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < single.getCount(); i++)
+    {
+        const Vec2 a = single.getPosition(i);
+        const Vec2 b = pooled.getPosition(i);
+        mismatches += a.x != b.x || a.y != b.y ? 1 : 0;
+    }
+    CHECK(mismatches == 0);
+}
+
+BENCHMARK(crowdUpdate)
+{
+    const WorldSnapshot world = makeBoxWorld();
+    const unsigned poolThreads = std::max(std::thread::hardware_concurrency(), 4u);
+
+    // What every step used to pay before workers were kept between steps
+    const double spawnMilliseconds = Tests::measure(100, [&]() {
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < poolThreads; i++)
+        {
+            threads.emplace_back([]() {});
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        });
+    std::cout << "        Spawning and joining " << poolThreads - 1 << " threads: " << spawnMilliseconds << " ms" << std::endl;
+
+    for (size_t count : { 10000, 100000, 500000 })
+    {
+        for (unsigned threads : { 1u, poolThreads })
+        {
+            Crowd crowd;
+            crowd.setThreadCount(threads);
+            fillCrowd(crowd, count);
+            crowd.update(STEP_TIME, world); // Starts workers and sorts bodies
+
+            const double milliseconds = Tests::measure(100, [&]() { crowd.update(STEP_TIME, world); });
+            std::cout << "        " << count << " bodies, " << threads << " threads: " << milliseconds << " ms per step" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "Tests.h"
+
+#include "Core/EventQueue.h"
+
+#include <thread>
+#include <vector>
+
+struct QueueItem
+{
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+TEST(fullEventQueueDropsAndCounts)
+{
+    EventQueue<QueueItem, 8> queue;
+
+    // Several laps, so slots are reused with later sequence numbers
+    uint32_t sequence = 0;
+    uint64_t expectedDropped = 0;
+    for (int lap = 0; lap < 3; lap++)
+    {
+        for (size_t i = 0; i < queue.capacity(); i++)
+        {
+            CHECK(queue.push({ 0, sequence++ }));
+        }
+        CHECK(!queue.push({ 0, 999 }));
+        CHECK(!queue.push({ 0, 999 }));
+        expectedDropped += 2;
+        CHECK(queue.getDroppedCount() == expectedDropped);
+
+        QueueItem item;
+        for (size_t i = 0; i < queue.capacity(); i++)
+        {
+            CHECK(queue.pop(item) && item.sequence == sequence - queue.capacity() + i);
+        }
+        CHECK(!queue.pop(item));
+    }
+}
+
+static const uint32_t PRODUCERS = 4;
+static const uint32_t ITEMS_PER_PRODUCER = 20000;
+
+TEST(eventQueueKeepsOrderOfEveryProducer)
+{
+    // Small queue, producers keep running into it being full
+    EventQueue<QueueItem, 16> queue;
+    std::vector<uint64_t> failedPushes(PRODUCERS, 0);
+
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < PRODUCERS; producer++)
+    {
+        producers.emplace_back([&queue, &failedPushes, producer]()
+            {
+                for (uint32_t sequence = 0; sequence < ITEMS_PER_PRODUCER; sequence++)
+                {
+                    // Dropped pushes are retried, so every item has to arrive
+                    while (!queue.push({ producer, sequence }))
+                    {
+                        failedPushes[producer]++;
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+
+    std::vector<uint32_t> nextSequence(PRODUCERS, 0);
+    uint64_t received = 0;
+    bool ordered = true;
+    while (received < (uint64_t)PRODUCERS * ITEMS_PER_PRODUCER)
+    {
+        QueueItem item;
+        if (!queue.pop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ordered = ordered && item.producer < PRODUCERS && item.sequence == nextSequence[item.producer];
+        if (item.producer < PRODUCERS)
+        {
+            nextSequence[item.producer] = item.sequence + 1;
+        }
+        received++;
+    }
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+
+    CHECK(ordered);
+    for (uint32_t producer = 0; producer < PRODUCERS; producer++)
+    {
+        CHECK(nextSequence[producer] == ITEMS_PER_PRODUCER);
+    }
+
+    QueueItem item;
+    CHECK(!queue.pop(item));
+
+    uint64_t failed = 0;
+    for (uint64_t count : failedPushes)
+    {
+        failed += count;
+    }
+    CHECK(queue.getDroppedCount() == failed);
+}
@@ -0,0 +1,379 @@
+#include "Tests.h"
+
+#include "PlatformInterface/InputCapture.h"
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint64_t FRAME_PERIOD = 5000000; // 5 ms in nanoseconds
+
+static std::string getCapturePath(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Scripted desktop, replaying it with the same seed and busy flags gives the same frames
+// Frames alternate between mouse moves, window list changes and mouse events.
+class CaptureScript
+{
+public:
+    explicit CaptureScript(uint32_t seed) : random(seed)
+    {
+        for (int i = 0; i < 30; i++)
+        {
+            addWindow(windows.size());
+        }
+    }
+
+    // Makes next frame and writes it when writer is given
+    // Busy frames move every window, so they encode to many bytes
+    void step(InputCaptureWriter* writer, bool busy)
+    {
+        // Window list is unknown to the capture until its first windows frame
+        const bool first = framesCount == 0;
+        time = framesCount++ * FRAME_PERIOD;
+        hasEvent = false;
+
+        const uint32_t kind = random() % 100;
+        if (busy || first || kind < 25)
+        {
+            changeWindows(busy);
+            if (writer) writer->writeWindows(time, windows);
+        }
+        else if (kind < 85)
+        {
+            mouse.x += randomDelta();
+            mouse.y += randomDelta();
+            if (random() % 10 == 0)
+            {
+                mouse.buttons ^= 1;
+            }
+            if (writer) writer->writeMouse(time, mouse);
+        }
+        else
+        {
+            hasEvent = true;
+            event.type = (InputEvent::Type)(random() % 3);
+            event.x = (int)(random() % 2200) - 200;
+            event.y = (int)(random() % 1300) - 100;
+            if (writer) writer->writeEvent(time, event);
+        }
+    }
+
+    uint64_t getTime() const { return time; }
+
+    // Counts frames where reader state differs from script state
+    void check(InputCaptureReader& reader, int& mismatches) const
+    {
+        bool same = reader.getMouse() == mouse && reader.getWindows().size() == windows.size();
+        for (size_t i = 0; same && i < windows.size(); i++)
+        {
+            const WindowData& a = reader.getWindows()[i];
+            const WindowData& b = windows[i];
+            same = a.id == b.id && a.title == b.title && a.className == b.className &&
+                a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h && a.zOrder == b.zOrder;
+        }
+
+        InputEvent read;
+        if (hasEvent)
+        {
+            same = same && reader.popEvent(read) && read.type == event.type && read.x == event.x && read.y == event.y;
+        }
+        same = same && !reader.popEvent(read);
+
+        if (!same)
+        {
+            mismatches++;
+        }
+    }
+private:
+    std::mt19937 random;
+    uint64_t framesCount = 0;
+    uint64_t time = 0;
+    size_t nextId = 0x10000;
+
+    InputMouseState mouse;
+    std::vector<WindowData> windows;
+    bool hasEvent = false;
+    InputEvent event;
+
+    int randomDelta()
+    {
+        const int delta = 1 + (int)(random() % 40);
+        return random() % 2 ? delta : -delta;
+    }
+
+    const wchar_t* randomTitle()
+    {
+        static const wchar_t* titles[] = { L"Untitled - Notepad", L"Inbox - Mail", L"", L"\u00dcn\u00efc\u00f6de \u2713", L"Downloads" };
+        return titles[random() % 5];
+    }
+
+    void addWindow(size_t index)
+    {
+        static const wchar_t* classNames[] = { L"Notepad", L"Chrome_WidgetWin_1", L"CabinetWClass" };
+
+        WindowData window(nextId, randomTitle(), classNames[random() % 3],
+            (int)(random() % 1800) - 100, (int)(random() % 1000), 200 + (int)(random() % 600), 150 + (int)(random() % 400), (int)index);
+        nextId += 0x1234567;
+        windows.insert(windows.begin() + index, window);
+    }
+
+    void changeWindows(bool busy)
+    {
+        if (busy)
+        {
+            for (WindowData& window : windows)
+            {
+                window.x += randomDelta();
+                window.y += randomDelta();
+            }
+            return;
+        }
+
+        const int changes = 1 + (int)(random() % 3);
+        for (int i = 0; i < changes; i++)
+        {
+            const size_t index = random() % windows.size();
+            switch (random() % 6)
+            {
+            case 0:
+                windows[index].x += randomDelta();
+                windows[index].y += randomDelta();
+                break;
+            case 1:
+                windows[index].w += randomDelta();
+                windows[index].h += randomDelta();
+                break;
+            case 2:
+                // Reordered windows are encoded as changes with a skew
+                if (index + 1 < windows.size())
+                {
+                    std::swap(windows[index], windows[index + 1]);
+                    std::swap(windows[index].zOrder, windows[index + 1].zOrder);
+                }
+                break;
+            case 3:
+                if (windows.size() > 5)
+                {
+                    windows.erase(windows.begin() + index);
+                }
+                break;
+            case 4:
+                addWindow(index);
+                break;
+            case 5:
+                windows[index].title = randomTitle();
+                break;
+            }
+        }
+    }
+};
+
+static const uint32_t SCRIPT_SEED = 1234;
+static const int SCRIPT_FRAMES = 14000; // 70 seconds, several keyframes
+
+static void writeScript(const std::string& path)
+{
+    InputCaptureWriter writer;
+    writer.open(path, 1920, 1080);
+
+    CaptureScript script(SCRIPT_SEED);
+    for (int i = 0; i < SCRIPT_FRAMES; i++)
+    {
+        script.step(&writer, false);
+    }
+    writer.close();
+}
+
+TEST(inputCaptureReadsBackEveryFrame)
+{
+    const std::string path = getCapturePath("capture_roundtrip.dcic");
+    writeScript(path);
+
+    InputCaptureReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.getKeyframes().size() >= 7);
+
+    int width = 0, height = 0;
+    reader.getScreenResolution(width, height);
+    CHECK(width == 1920 && height == 1080);
+
+    CaptureScript script(SCRIPT_SEED);
+    int mismatches = 0;
+    bool advanced = true;
+    for (int i = 0; i < SCRIPT_FRAMES && advanced; i++)
+    {
+        script.step(nullptr, false);
+        advanced = reader.advance(script.getTime()) || i == SCRIPT_FRAMES - 1;
+        script.check(reader, mismatches);
+    }
+    CHECK(advanced);
+    CHECK(mismatches == 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST(inputCaptureSeeksToMiddle)
+{
+    const std::string path = getCapturePath("capture_seek.dcic");
+    writeScript(path);
+
+    InputCaptureReader reader;
+    CHECK(reader.open(path));
+
+    // Starts from the keyframe before the middle frame and applies frames up to it
+    CaptureScript script(SCRIPT_SEED);
+    for (int i = 0; i <= SCRIPT_FRAMES / 2; i++)
+    {
+        script.step(nullptr, false);
+    }
+    CHECK(reader.seek(script.getTime()));
+    CHECK(reader.getTime() <= script.getTime());
+    CHECK(reader.getTime() > 0);
+    CHECK(reader.advance(script.getTime()));
+
+    // Events before the middle frame were applied too
+    InputEvent event;
+    while (reader.popEvent(event))
+    {
+    }
+    reader.clearEvents();
+
+    int mismatches = 0;
+    for (int i = SCRIPT_FRAMES / 2 + 1; i < SCRIPT_FRAMES; i++)
+    {
+        script.step(nullptr, false);
+        reader.advance(script.getTime());
+        script.check(reader, mismatches);
+    }
+    CHECK(mismatches == 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST(inputCaptureReadsUnclosedFile)
+{
+    const std::string path = getCapturePath("capture_closed.dcic");
+    const std::string cutPath = getCapturePath("capture_cut.dcic");
+    writeScript(path);
+
+    // Index and trailer are lost, last record is cut in the middle
+    std::filesystem::copy_file(path, cutPath, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(cutPath, std::filesystem::file_size(path) * 6 / 10 + 3);
+
+    InputCaptureReader closed;
+    CHECK(closed.open(path));
+
+    InputCaptureReader reader;
+    CHECK(reader.open(cutPath));
+
+    // Scanned keyframes are the leading ones of the index
+    const std::vector<InputKeyframe>& all = closed.getKeyframes();
+    const std::vector<InputKeyframe>& found = reader.getKeyframes();
+    CHECK(found.size() >= 2 && found.size() < all.size());
+    for (size_t i = 0; i < found.size() && i < all.size(); i++)
+    {
+        CHECK(found[i].time == all[i].time && found[i].offset == all[i].offset);
+    }
+
+    CaptureScript script(SCRIPT_SEED);
+    int mismatches = 0;
+    int framesRead = 0;
+    for (int i = 0; i < SCRIPT_FRAMES; i++)
+    {
+        script.step(nullptr, false);
+        if (!reader.advance(script.getTime()))
+        {
+            break;
+        }
+        script.check(reader, mismatches);
+        framesRead++;
+    }
+    CHECK(mismatches == 0);
+    CHECK(framesRead > SCRIPT_FRAMES / 2 && framesRead < SCRIPT_FRAMES - 1);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(cutPath);
+}
+
+TEST(inputCaptureRecoversFromDroppedChunk)
+{
+    const std::string path = getCapturePath("capture_dropped.dcic");
+
+    // Frame index script was at when writing paused, and of the last frame lost to a drop
+    std::vector<bool> busy;
+    size_t pausedAt = 0;
+    size_t lastDropped = 0;
+    {
+        InputCaptureWriter writer;
+        writer.open(path, 1920, 1080);
+
+        CaptureScript script(SCRIPT_SEED);
+        auto step = [&](bool isBusy)
+            {
+                script.step(&writer, isBusy);
+                busy.push_back(isBusy);
+            };
+
+        for (int i = 0; i < 3000; i++)
+        {
+            step(false);
+        }
+
+        // Disk stalls until two chunks were dropped
+        pausedAt = busy.size();
+        writer.setWritingPaused(true);
+        uint64_t dropped = 0;
+        while (writer.getDroppedChunksCount() < 2 && busy.size() < 200000)
+        {
+            step(true);
+            if (writer.getDroppedChunksCount() != dropped)
+            {
+                dropped = writer.getDroppedChunksCount();
+                lastDropped = busy.size() - 1;
+            }
+        }
+        for (int i = 0; i < 20; i++)
+        {
+            step(false);
+        }
+        writer.setWritingPaused(false);
+        CHECK(writer.getDroppedChunksCount() == 2);
+
+        for (int i = 0; i < 3000; i++)
+        {
+            step(false);
+        }
+        writer.close();
+        CHECK(writer.getDroppedChunksCount() == 2);
+    }
+
+    InputCaptureReader reader;
+    CHECK(reader.open(path));
+
+    // Frames before the stall and after the last drop decode exactly, the gap is skipped
+    CaptureScript script(SCRIPT_SEED);
+    int mismatches = 0;
+    bool advanced = true;
+    for (size_t i = 0; i < busy.size(); i++)
+    {
+        script.step(nullptr, busy[i]);
+        advanced = advanced && (reader.advance(script.getTime()) || i == busy.size() - 1);
+
+        if (i < pausedAt || i > lastDropped)
+        {
+            script.check(reader, mismatches);
+        }
+        else
+        {
+            reader.clearEvents();
+        }
+    }
+    CHECK(advanced);
+    CHECK(mismatches == 0);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,176 @@
+#include "Tests.h"
+
+#include "Core/IntervalSet.h"
+#include "Core/Random.h"
+#include "Obstacle.h"
+
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+static const int BITMAP_SIZE = 64;
+
+// Whole cells covered by set, checked at cell centers
+static bool matchesBitmap(const IntervalSet& set, const bool* bitmap)
+{
+    for (int cell = 0; cell < BITMAP_SIZE; cell++)
+    {
+        size_t index;
+        const float center = (float)cell + 0.5f;
+        if (set.findOverlap(center - 0.25f, center + 0.25f, index) != bitmap[cell])
+        {
+            return false;
+        }
+    }
+
+    // Sorted, disjoint and not touching
+    for (size_t i = 1; i < set.size(); i++)
+    {
+        if (set[i].min <= set[i - 1].max)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(intervalSetMatchesBitmap)
+{
+    for (int sequence = 0; sequence < 200; sequence++)
+    {
+        IntervalSet set;
+        bool bitmap[BITMAP_SIZE] = {};
+
+        for (int operation = 0; operation < 40; operation++)
+        {
+            const int min = Random::Int(0, BITMAP_SIZE - 1);
+            const int max = Random::Int(min, BITMAP_SIZE);
+            const bool adding = Random::Int(0, 2) != 0;
+
+            if (adding)
+            {
+                set.insert(Range((float)min, (float)max));
+            }
+            else
+            {
+                set.subtract(Range((float)min, (float)max));
+            }
+            for (int cell = min; cell < max; cell++)
+            {
+                bitmap[cell] = adding;
+            }
+
+            CHECK(matchesBitmap(set, bitmap));
+        }
+    }
+}
+
+TEST(movedFromIntervalSetIsEmpty)
+{
+    IntervalSet source;
+    for (int i = 0; i < 8; i++)
+    {
+        source.insert(Range((float)i * 2.0f, (float)i * 2.0f + 1.0f));
+    }
+
+    IntervalSet moved(std::move(source));
+    CHECK(moved.size() == 8);
+    CHECK(source.empty());
+    CHECK(source.begin() == source.end());
+
+    // Reusable after move, from inline storage again
+    source.insert(Range(0.0f, 1.0f));
+    CHECK(source.size() == 1);
+
+    IntervalSet assigned;
+    assigned = std::move(moved);
+    CHECK(assigned.size() == 8);
+    CHECK(moved.empty());
+    CHECK(assigned.back().max == 15.0f);
+}
+
+TEST(coalesceJoinsNearlyTouchingSegments)
+{
+    std::vector<Obstacle> obstacles;
+    obstacles.emplace_back(Obstacle::Type::Horizontal, 0.0f, 0.0f, 1.0f);
+    obstacles.emplace_back(Obstacle::Type::Horizontal, 0.001f, 1.005f, 2.0f);
+    obstacles.emplace_back(Obstacle::Type::Horizontal, 0.0f, 2.5f, 3.0f);
+
+    Obstacle::coalesce(obstacles, 0.01f);
+
+    CHECK(obstacles.size() == 1);
+    CHECK(obstacles[0].segments.size() == 2);
+    CHECK(obstacles[0].segments[0].min == 0.0f);
+    CHECK(obstacles[0].segments[0].max == 2.0f);
+}
+
+// Cutting edges as obstacles were before IntervalSet, a new vector per occluder
+static void cutVector(std::vector<Range>& segments, const Range& cut)
+{
+    std::vector<Range> newSegments;
+    for (const Range& segment : segments)
+    {
+        const float left = fmaxf(segment.min, cut.min);
+        const float right = fminf(segment.max, cut.max);
+        if (left >= right)
+        {
+            newSegments.push_back(segment);
+            continue;
+        }
+        if (segment.min < left)
+        {
+            newSegments.emplace_back(segment.min, left);
+        }
+        if (right < segment.max)
+        {
+            newSegments.emplace_back(right, segment.max);
+        }
+    }
+    segments = std::move(newSegments);
+}
+
+BENCHMARK(intervalSetCutting)
+{
+    const int edgesCount = 1000000;
+
+    for (int occludersCount : { 1, 8 })
+    {
+        std::vector<Range> occluders;
+        for (int i = 0; i < occludersCount; i++)
+        {
+            const float min = Random::Float(0.0f, 0.9f);
+            occluders.emplace_back(min, min + 0.1f);
+        }
+
+        size_t vectorSegments = 0;
+        const double vectorTime = Tests::measure(1, [&]() {
+            for (int edge = 0; edge < edgesCount; edge++)
+            {
+                std::vector<Range> segments = { Range(0.0f, 1.0f) };
+                for (const Range& occluder : occluders)
+                {
+                    cutVector(segments, occluder);
+                }
+                vectorSegments += segments.size();
+            }
+            });
+
+        size_t setSegments = 0;
+        const double setTime = Tests::measure(1, [&]() {
+            for (int edge = 0; edge < edgesCount; edge++)
+            {
+                IntervalSet segments(Range(0.0f, 1.0f));
+                for (const Range& occluder : occluders)
+                {
+                    segments.subtract(occluder);
+                }
+                setSegments += segments.size();
+            }
+            });
+
+        CHECK(vectorSegments == setSegments);
+        std::cout << "        " << occludersCount << " occluders, " << edgesCount << " edges: vector " << vectorTime
+            << " ms, IntervalSet " << setTime << " ms" << std::endl;
+    }
+}
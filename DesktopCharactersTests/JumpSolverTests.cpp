@@ -0,0 +1,170 @@
+#include "Tests.h"
+
+#include "Character.h"
+#include "Core/Random.h"
+#include "JumpSolver.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+static const Vec2 BODY_SIZE(0.05f, 0.05f);
+
+static JumpSolver makeSolver(float stepTime)
+{
+    JumpSolver::Settings settings;
+    settings.maxSpeed = 1.0f;
+    settings.maxJumpVelocity = 3.0f;
+    settings.gravity = -Character::gravity.y;
+    settings.bodySize = BODY_SIZE;
+    settings.stepTime = stepTime;
+    return JumpSolver(settings);
+}
+
+static JumpSolver::Segment randomTarget(float minY, float maxY)
+{
+    const float width = Random::Float(0.1f, 0.6f);
+    const float minX = Random::Float(-1.2f, 1.2f - width);
+    return { Random::Float(minY, maxY), Range(minX, minX + width) };
+}
+
+// Steps a real character from takeoff until it stands on something, true if that is the target
+static bool landsOnTarget(const JumpSolver::Segment& from, const JumpSolver::Segment& to, const JumpSolver::Launch& launch, float stepTime)
+{
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, from.y, from.x.min, from.x.max);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, to.y, to.x.min, to.x.max);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -1.0f, -2.0f, 2.0f);
+    world.finalize();
+
+    Character::Data data;
+    data.maxSpeed = 1.0f;
+    data.maxJumpVelocity = 3.0f;
+
+    Character character(Vec2(launch.takeoffX, from.y + BODY_SIZE.y * 0.5f), BODY_SIZE, data);
+    character.setVelocity(launch.velocity);
+    character.updateAABB();
+
+    for (int step = 0; step < 1000; step++)
+    {
+        character.update(stepTime, world);
+        if (character.getGroundedData().isGrounded)
+        {
+            return fabsf(character.getAABB().minY - to.y) < 1e-3f;
+        }
+    }
+    return false;
+}
+
+TEST(jumpSolverMatchesSteppedMotion)
+{
+    const JumpSolver::Segment from = { -0.5f, Range(-0.6f, -0.1f) };
+
+    for (float stepTime : { 1.0f / 60.0f, 1.0f / 15.0f })
+    {
+        const JumpSolver solver = makeSolver(stepTime);
+
+        int jumps = 0, drops = 0;
+        for (int i = 0; i < 2000; i++)
+        {
+            JumpSolver::Launch launch;
+
+            const JumpSolver::Segment up = randomTarget(-0.45f, -0.35f);
+            if (solver.solveJump(from, up, launch))
+            {
+                CHECK(landsOnTarget(from, up, launch, stepTime));
+                jumps++;
+            }
+
+            const JumpSolver::Segment down = randomTarget(-0.95f, -0.6f);
+            const float side = Random::Int(0, 1) ? 1.0f : -1.0f;
+            if (solver.solveDrop(from, side, down, launch))
+            {
+                CHECK(landsOnTarget(from, down, launch, stepTime));
+                drops++;
+            }
+        }
+
+        // Enough of both kinds were reachable to mean something
+        CHECK(jumps > 20);
+        CHECK(drops > 20);
+    }
+}
+
+TEST(jumpSolverBatchMatchesSingle)
+{
+    const JumpSolver solver = makeSolver(1.0f / 60.0f);
+    const JumpSolver::Segment from = { -0.5f, Range(-0.6f, -0.1f) };
+
+    const size_t count = 103; // Not a multiple of 4, leftovers go through the scalar path
+    std::vector<float> y(count), minX(count), maxX(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const JumpSolver::Segment target = randomTarget(-0.95f, -0.1f);
+        y[i] = target.y;
+        minX[i] = target.x.min;
+        maxX[i] = target.x.max;
+    }
+    const JumpSolver::Segments targets = { y.data(), minX.data(), maxX.data(), count };
+
+    std::vector<float> takeoffX(count), velocityX(count), time(count), dropTime(count);
+    solver.solveJumps(from, targets, takeoffX.data(), velocityX.data(), time.data());
+    solver.solveDrops(from, 1.0f, targets, dropTime.data());
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const JumpSolver::Segment to = { y[i], Range(minX[i], maxX[i]) };
+
+        JumpSolver::Launch launch;
+        const bool jump = solver.solveJump(from, to, launch);
+        CHECK(jump == (time[i] >= 0.0f));
+        if (jump)
+        {
+            CHECK(fabsf(takeoffX[i] - launch.takeoffX) < 1e-4f);
+            CHECK(velocityX[i] == launch.velocity.x);
+            CHECK(fabsf(time[i] - launch.time) < 1e-4f);
+        }
+
+        const bool drop = solver.solveDrop(from, 1.0f, to, launch);
+        CHECK(drop == (dropTime[i] >= 0.0f));
+    }
+}
+
+BENCHMARK(jumpSolverBatch)
+{
+    const JumpSolver solver = makeSolver(1.0f / 60.0f);
+    const JumpSolver::Segment from = { -0.5f, Range(-0.6f, -0.1f) };
+
+    for (size_t count : { 64, 1024 })
+    {
+        std::vector<float> y(count), minX(count), maxX(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const JumpSolver::Segment target = randomTarget(-0.95f, -0.1f);
+            y[i] = target.y;
+            minX[i] = target.x.min;
+            maxX[i] = target.x.max;
+        }
+        const JumpSolver::Segments targets = { y.data(), minX.data(), maxX.data(), count };
+        std::vector<float> takeoffX(count), velocityX(count), time(count);
+
+        const int repeats = 20000;
+        const double batchTime = Tests::measure(repeats, [&]() {
+            solver.solveJumps(from, targets, takeoffX.data(), velocityX.data(), time.data());
+            });
+
+        float sink = 0.0f;
+        const double singleTime = Tests::measure(repeats, [&]() {
+            JumpSolver::Launch launch;
+            for (size_t i = 0; i < count; i++)
+            {
+                const JumpSolver::Segment to = { y[i], Range(minX[i], maxX[i]) };
+                sink += solver.solveJump(from, to, launch) ? launch.time : 0.0f;
+            }
+            });
+
+        std::cout << "        " << count << " targets: batch " << batchTime * 1e3 << " us, one by one "
+            << singleTime * 1e3 << " us" << (sink < 0.0f ? " " : "") << std::endl;
+    }
+}
@@ -0,0 +1,40 @@
+#include "Tests.h"
+
+#include "Core/MetricsExporter.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+static std::string readFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+TEST(metricsKeepLatestValuesOnly)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "metrics_test.prom";
+
+    MetricsExporter metrics;
+    CHECK(metrics.open(path.string()));
+
+    metrics.set("frames_total", 1.0, MetricsExporter::Type::Counter);
+    metrics.set("frame_time_ms", 16.0, MetricsExporter::Type::Gauge, "quantile=\"0.5\"");
+    metrics.set("frame_time_ms", 20.0, MetricsExporter::Type::Gauge, "quantile=\"0.9\"");
+    CHECK(metrics.write());
+
+    metrics.set("frames_total", 123456789.0, MetricsExporter::Type::Counter);
+    CHECK(metrics.write());
+
+    const std::string text = readFile(path);
+    CHECK(text ==
+        "# TYPE frames_total counter\n"
+        "frames_total 123456789\n"
+        "# TYPE frame_time_ms gauge\n"
+        "frame_time_ms{quantile=\"0.5\"} 16\n"
+        "frame_time_ms{quantile=\"0.9\"} 20\n");
+    CHECK(!std::filesystem::exists(path.string() + ".tmp"));
+}
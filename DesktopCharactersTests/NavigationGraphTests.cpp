@@ -0,0 +1,76 @@
+#include "Tests.h"
+
+#include "NavigationGraph.h"
+
+static const Vec2 CHARACTER_SIZE(0.05f, 0.05f);
+
+static Character::Data makeData(float maxJumpVelocity)
+{
+    Character::Data data;
+    data.maxSpeed = 1.0f;
+    data.maxJumpVelocity = maxJumpVelocity;
+    return data;
+}
+
+TEST(jumpLaunchesWithPlannedVelocity)
+{
+    // Floor, and a low step only a jump reaches
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -0.92f, 0.3f, 0.8f);
+    world.finalize();
+
+    // Edges are solved for the weaker jumper
+    NavigationGraph navigation;
+    navigation.fitCharacter(CHARACTER_SIZE, makeData(3.0f), 1.0f / 60.0f);
+    navigation.fitCharacter(CHARACTER_SIZE, makeData(2.2f), 1.0f / 60.0f);
+    navigation.update(world);
+    navigation.setTarget(Vec2(0.55f, -0.8f));
+
+    Character strongJumper(Vec2(-0.5f, -1.0f + CHARACTER_SIZE.y * 0.5f), CHARACTER_SIZE, makeData(3.0f));
+    strongJumper.updateAABB();
+
+    NavigationGraph::Waypoint waypoint;
+    CHECK(navigation.getWaypoint(strongJumper, waypoint));
+    CHECK(waypoint.jump);
+    CHECK(waypoint.jumpVelocity.y == 2.2f);
+
+    // At takeoff the stronger character jumps as planned, not at its own maximum
+    strongJumper.move(waypoint.position.x - strongJumper.getPosition().x, 0.0f);
+    strongJumper.updateAABB();
+
+    Character::FollowTarget target;
+    target.exist = true;
+    target.position = waypoint.position;
+    target.jump = true;
+    target.jumpVelocity = waypoint.jumpVelocity;
+    strongJumper.setFollowTarget(target);
+    strongJumper.update(1.0f / 60.0f, world);
+
+    CHECK(strongJumper.getVelocity().y == 2.2f);
+    CHECK(strongJumper.getVelocity().x == waypoint.jumpVelocity.x);
+}
+
+TEST(onlyWindowTopsAreWindowTops)
+{
+    // Floor and one window, its bottom edge is a platform too
+    WorldSnapshot world;
+    world.size = Vec2(2.0f, 1.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -1.0f, -2.0f, 2.0f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, 0.5f, -0.5f, 0.5f);
+    world.obstacles.emplace_back(Obstacle::Type::Horizontal, -0.5f, -0.5f, 0.5f);
+    world.windowTops.emplace_back(Obstacle::Type::Horizontal, 0.5f, -0.5f, 0.5f);
+    world.finalize();
+
+    NavigationGraph navigation;
+    navigation.fitCharacter(CHARACTER_SIZE, makeData(3.0f), 1.0f / 60.0f);
+    navigation.update(world);
+
+    const std::vector<NavigationGraph::Platform>& platforms = navigation.getPlatforms();
+    CHECK(platforms.size() == 3);
+    for (const NavigationGraph::Platform& platform : platforms)
+    {
+        CHECK(platform.windowTop == (platform.y == 0.5f));
+    }
+}
@@ -0,0 +1,16 @@
+#include "Tests.h"
+
+#include "QualityGovernor.h"
+
+TEST(slowRenderFramesLowerQuality)
+{
+    QualityGovernor governor;
+    for (int i = 0; i < 60; i++)
+    {
+        governor.addRenderFrameTime(30.0);
+    }
+
+    CHECK(governor.update(1.0f));
+    CHECK(governor.getLevel() == QualityGovernor::Level::NoObstacleOverlay);
+    CHECK(governor.getLastPercentile() >= 30.0);
+}
@@ -0,0 +1,81 @@
+#include "Tests.h"
+
+#include "SimulationState.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static std::string getStatePath(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static SimulationState makeState(size_t charactersCount)
+{
+    SimulationState state;
+    state.worldSize = Vec2(2.0f, 1.0f);
+
+    Character::Data data;
+    data.maxSpeed = 1.0f;
+    const uint16_t type = state.getCharacterType(data);
+
+    for (size_t i = 0; i < charactersCount; i++)
+    {
+        SimulationState::CharacterState character = {};
+        character.position = Vec2((float)i * 1e-3f, 0.5f);
+        character.velocity = Vec2(0.25f, -1.0f);
+        character.size = Vec2(0.05f, 0.05f);
+        character.type = type;
+        character.animationState = Character::AnimationState::Walk;
+        state.characters.push_back(character);
+    }
+    state.randomState = "1 2 3";
+    return state;
+}
+
+TEST(simulationStateRoundTrip)
+{
+    const std::string path = getStatePath("state_roundtrip.sav");
+    const SimulationState saved = makeState(100);
+    CHECK(saved.save(path));
+
+    // Saving again replaces the file
+    CHECK(saved.save(path));
+    CHECK(!std::filesystem::exists(path + ".tmp"));
+
+    SimulationState loaded;
+    CHECK(loaded.load(path));
+    CHECK(loaded.characters.size() == 100);
+    CHECK(loaded.characters[99].position.x == saved.characters[99].position.x);
+    CHECK(loaded.characters[99].animationState == Character::AnimationState::Walk);
+    CHECK(loaded.randomState == saved.randomState);
+}
+
+TEST(simulationStateRejectsBadAnimationState)
+{
+    const std::string path = getStatePath("state_animation.sav");
+    SimulationState saved = makeState(1);
+    const char badState = 7;
+    memcpy(&saved.characters[0].animationState, &badState, sizeof(badState));
+    CHECK(saved.save(path));
+
+    SimulationState loaded;
+    CHECK(!loaded.load(path));
+}
+
+BENCHMARK(simulationStateSaveLoad)
+{
+    const std::string path = getStatePath("state_bench.sav");
+    const SimulationState saved = makeState(10000);
+
+    const double saveTime = Tests::measure(20, [&]() { saved.save(path); });
+
+    SimulationState loaded;
+    const double loadTime = Tests::measure(20, [&]() { loaded.load(path); });
+
+    std::cout << "        10000 characters, " << std::filesystem::file_size(path) / 1024 << " KB: save " << saveTime
+        << " ms, load " << loadTime << " ms" << std::endl;
+}
@@ -0,0 +1,57 @@
+#include "Tests.h"
+
+#include "Window/Renderer/SpriteAtlas.h"
+
+#include <filesystem>
+#include <fstream>
+
+// Run from the solution directory or the test project directory
+static std::filesystem::path findAssets()
+{
+    for (const char* candidate : { "DesktopCharacters/Assets", "../DesktopCharacters/Assets" })
+    {
+        if (std::filesystem::exists(std::filesystem::path(candidate) / "characters.atlas"))
+        {
+            return candidate;
+        }
+    }
+    return std::filesystem::path();
+}
+
+static std::filesystem::path writeAtlas(const char* name, const char* text)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path) << text;
+    return path;
+}
+
+TEST(shippedAtlasLoads)
+{
+    const std::filesystem::path assets = findAssets();
+    CHECK(!assets.empty());
+
+    SpriteAtlas atlas;
+    CHECK(atlas.load(assets / "characters.atlas"));
+    CHECK(std::filesystem::exists(atlas.getImagePath()));
+
+    for (const char* name : { "idle", "walk", "fall", "drag" })
+    {
+        CHECK(atlas.getAnimationIndex(name) != -1);
+    }
+}
+
+TEST(atlasRejectsBadFrameCounts)
+{
+    SpriteAtlas atlas;
+    CHECK(!atlas.load(writeAtlas("negative.atlas", "image a.png\nidle -1 2 0 0 32 32\n")));
+    CHECK(!atlas.load(writeAtlas("huge.atlas", "image a.png\nidle 100000000 2 0 0 32 32\n")));
+    CHECK(!atlas.load(writeAtlas("empty.atlas", "image a.png\nidle 2 2 0 0 0 32\n")));
+    CHECK(atlas.load(writeAtlas("good.atlas", "image a.png\nidle 2 2 0 0 32 32\n")));
+}
+
+TEST(atlasImagePathIsUtf8)
+{
+    SpriteAtlas atlas;
+    CHECK(atlas.load(writeAtlas("utf8.atlas", "image \xd0\xbf\xd0\xb5\xd1\x80\xd1\x81.png\nidle 1 1 0 0 8 8\n")));
+    CHECK(std::filesystem::path(atlas.getImagePath()).filename().wstring() == L"\u043f\u0435\u0440\u0441.png");
+}
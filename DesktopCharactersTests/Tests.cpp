@@ -0,0 +1,49 @@
+#include "Tests.h"
+
+#include <iostream>
+
+int Tests::failedChecksCount = 0;
+
+Tests::Registration::Registration(const char* name, Function function, bool benchmark)
+{
+    getEntries().push_back({ name, function, benchmark });
+}
+
+// Returns number of failed checks
+int Tests::run(bool withBenchmarks)
+{
+    for (const Entry& entry : getEntries())
+    {
+        if (entry.benchmark && !withBenchmarks)
+        {
+            continue;
+        }
+
+        const int failedBefore = failedChecksCount;
+        std::cout << (entry.benchmark ? "[bench] " : "[test]  ") << entry.name << std::endl;
+        entry.function();
+        if (failedChecksCount != failedBefore)
+        {
+            std::cout << "        FAILED" << std::endl;
+        }
+    }
+
+    std::cout << (failedChecksCount == 0 ? "All checks passed" : "Some checks failed") << std::endl;
+    return failedChecksCount;
+}
+
+void Tests::check(bool condition, const char* expression, const char* file, int line)
+{
+    if (!condition)
+    {
+        failedChecksCount++;
+        std::cout << "        " << file << "(" << line << "): check failed: " << expression << std::endl;
+    }
+}
+
+// Function local, registrations of other files may run first
+std::vector<Tests::Entry>& Tests::getEntries()
+{
+    static std::vector<Entry> entries;
+    return entries;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+// Minimal test runner, tests and benchmarks register themselves from their own files
+// Tests run on every start, benchmarks only with --bench.
+class Tests
+{
+public:
+    using Function = void(*)();
+
+    struct Registration
+    {
+        Registration(const char* name, Function function, bool benchmark);
+    };
+
+    static int run(bool withBenchmarks);
+
+    static void check(bool condition, const char* expression, const char* file, int line);
+
+    // Average wall time of function over repeats calls, in milliseconds
+    template<typename F>
+    static double measure(int repeats, F&& function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+        {
+            function();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+    }
+private:
+    struct Entry
+    {
+        const char* name;
+        Function function;
+        bool benchmark;
+    };
+
+    static std::vector<Entry>& getEntries();
+    static int failedChecksCount;
+};
+
+#define TEST(name) \
+    static void name(); \
+    static Tests::Registration name##Registration(#name, name, false); \
+    static void name()
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static Tests::Registration name##Registration(#name, name, true); \
+    static void name()
+
+#define CHECK(condition) Tests::check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,15 @@
+#include "Tests.h"
+
+#include <cstring>
+
+// Usage: DesktopCharactersTests [--bench]
+int main(int argc, char** argv)
+{
+    bool withBenchmarks = false;
+    for (int i = 1; i < argc; i++)
+    {
+        withBenchmarks = withBenchmarks || strcmp(argv[i], "--bench") == 0;
+    }
+
+    return Tests::run(withBenchmarks) == 0 ? 0 : 1;
+}